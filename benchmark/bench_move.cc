@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "tieralloc.h"
+
+// GB/s per (src tier -> dst tier) for ta_move and for the raw ta_copy kernel.
+// Size per move: TA_BENCH_BYTES in MB (default 256).
+
+static const char* tier_name(int t) {
+    return t == TA_TIER_FAST ? "fast" : t == TA_TIER_NORMAL ? "normal" : "slow";
+}
+
+static ta_hint_t tier_hint(int t) {
+    return t == TA_TIER_FAST ? TA_HINT_PIN_FAST : t == TA_TIER_NORMAL ? TA_HINT_WARM : TA_HINT_COLD;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main() {
+    ta_init_from_env();
+    unsigned long long mb = 256;
+    if (const char* v = std::getenv("TA_BENCH_BYTES")) mb = std::strtoull(v, nullptr, 10);
+    const unsigned long long SZ = mb << 20;
+    const double GB = 1024.0 * 1024.0 * 1024.0;
+
+    std::printf("bytes=%llu\n", SZ);
+    std::printf("%-8s %-8s %12s %12s %12s\n", "src", "dst", "move_GBps", "copy_GBps", "memcpy_GBps");
+    for (int src = 0; src < 3; ++src) {
+        for (int dst = 0; dst < 3; ++dst) {
+            // ta_move: includes mapping, faulting and unmapping, as callers see it
+            void* p = ta_alloc_ex(SZ, tier_hint(src), TA_ALLOC_PREFAULT_PARALLEL);
+            if (!p) { std::fprintf(stderr, "alloc failed\n"); return 1; }
+            std::memset(p, 0x5a, (size_t)SZ);
+            auto t0 = std::chrono::steady_clock::now();
+            void* q = ta_move(p, (ta_tier_t)dst);
+            double move_s = seconds_since(t0);
+            if (!q) { std::fprintf(stderr, "move failed\n"); return 2; }
+
+            // Kernel only: both sides already resident
+            void* d = ta_alloc_ex(SZ, tier_hint(dst), TA_ALLOC_PREFAULT_PARALLEL);
+            if (!d) { std::fprintf(stderr, "alloc failed\n"); return 1; }
+            t0 = std::chrono::steady_clock::now();
+            ta_copy(d, q, SZ, (ta_tier_t)dst);
+            double copy_s = seconds_since(t0);
+            t0 = std::chrono::steady_clock::now();
+            std::memcpy(d, q, (size_t)SZ);
+            double memcpy_s = seconds_since(t0);
+
+            std::printf("%-8s %-8s %12.2f %12.2f %12.2f\n", tier_name(src), tier_name(dst),
+                        SZ / GB / move_s, SZ / GB / copy_s, SZ / GB / memcpy_s);
+            ta_free(q);
+            ta_free(d);
+        }
+    }
+    return 0;
+}
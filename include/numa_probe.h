@@ -1,5 +1,15 @@
 #pragma once
 #include <cstdint>
+#include <sched.h>
+
+#define TA_NUMA_MAX_NODES 64
+
+// How a tier spreads pages over its node set
+enum class ta_place_mode : uint8_t {
+  preferred,   // single node (first in the set)
+  interleave,  // kernel MPOL_INTERLEAVE, equal share per node
+  weighted     // kernel MPOL_WEIGHTED_INTERLEAVE, per-node page weights
+};
 
 struct ta_numa_info {
   bool available{false};    // NUMA presence
@@ -8,6 +18,24 @@ struct ta_numa_info {
   bool use_libnuma{false};  // chooose libnuma path over mbind
   int node_count{1};        // number of nodes (=max_node+1 if available)
   const char* backend{"simulated"};   // "numa" or "simulated"
+  cpu_set_t node_cpus[TA_NUMA_MAX_NODES]{};  // from sysfs cpulist; empty if unknown/CPU-less
+
+  // Multi-node tiers; tier_node[t] == tier_nodes[t][0]
+  int tier_nodes[3][TA_NUMA_MAX_NODES]{};
+  int tier_nnodes[3]{1,1,1};
+  unsigned tier_weights[3][TA_NUMA_MAX_NODES]{};  // relative; used by weighted mode
+  ta_place_mode tier_mode[3]{ta_place_mode::preferred, ta_place_mode::preferred, ta_place_mode::preferred};
+
+  // Topology from /sys/devices/system/node and the calibration file
+  bool auto_map{false};                               // tier map derived from topology
+  int distance[TA_NUMA_MAX_NODES][TA_NUMA_MAX_NODES]{}; // SLIT distances; 0 if unknown
+  unsigned long long node_mem_bytes[TA_NUMA_MAX_NODES]{};  // MemTotal; 0 if memoryless/unknown
+  double node_bw_Bps[TA_NUMA_MAX_NODES]{};            // calibrated read bandwidth; 0 if unknown
+  long node_lat_ns[TA_NUMA_MAX_NODES]{};              // calibrated load latency; 0 if unknown
+
+  // Locality: for each node, nodes with CPUs and memory ordered by distance (self first)
+  int nearest[TA_NUMA_MAX_NODES][TA_NUMA_MAX_NODES]{};
+  int nearest_count[TA_NUMA_MAX_NODES]{};
 };
 
 // Returns reference to singleton populated at init time
@@ -16,3 +44,9 @@ const ta_numa_info& ta_numa_probe();
 
 // Sets backend and node mapping
 void ta_numa_init_from_env();
+
+// Node owning cpu (-1 if unknown)
+int ta_numa_cpu_node(int cpu);
+
+// CPUs local to node; false if the node has none (or topology is unknown)
+bool ta_numa_node_cpus(int node, cpu_set_t* out);
@@ -14,13 +14,32 @@ typedef enum {
     TA_HINT_PREFER_FAST
 } ta_hint_t;
 
+// --- Allocation flags (ta_alloc_ex) ---
+typedef enum {
+    TA_ALLOC_NONE              = 0,
+    TA_ALLOC_POPULATE          = 1u << 0,  // prefault on the calling thread (MAP_POPULATE)
+    TA_ALLOC_PREFAULT_PARALLEL = 1u << 1,  // prefault on pool threads pinned to the tier's node
+    TA_ALLOC_NO_PREFAULT       = 1u << 2,  // ignore TA_PREFAULT default for this call
+    TA_ALLOC_HUGEPAGE          = 1u << 3   // 2MB-aligned, 2MB-rounded, MADV_HUGEPAGE
+} ta_alloc_flags_t;
+
 // --- Config ---
 typedef struct {
     double bandwidth_Bps;                 // bytes per second
     long   base_latency_ns;               // extra fixed latency
-    unsigned long long capacity_bytes;    // optional soft cap (later)
+    unsigned long long capacity_bytes;    // soft cap, 0 = uncapped
 } ta_tier_cfg_t;
 
+// When no tier is under its hard cap: put it in SLOW anyway, or fail the allocation
+// (NULL; ta_advise leaves the range where it is and returns -4)
+typedef enum { TA_HARDCAP_ROUTE_SLOW = 0, TA_HARDCAP_FAIL = 1 } ta_hardcap_action_t;
+
+typedef struct {
+    unsigned long long soft[3];           // per tier, 0 = uncapped (TA_*_SOFT)
+    unsigned long long hard[3];           // TA_*_HARD
+    int on_hardcap;                       // ta_hardcap_action_t (TA_ON_HARDCAP)
+} ta_caps_t;
+
 // --- Accounting structs ---
 typedef struct {
     long simulated_wait_ns;
@@ -46,21 +65,130 @@ long ta_charge_bytes(ta_tier_t tier, unsigned long long bytes, ta_charge_info_t*
 // Explicit allocation API
 void* ta_alloc(unsigned long long bytes, ta_hint_t hint);
 void  ta_free(void* p);
+void* ta_alloc_ex(unsigned long long bytes, ta_hint_t hint, unsigned flags);
+
+// Batch forms: one policy decision, throttle charge and mapping per distinct hint
+// (hints NULL: all TA_HINT_DEFAULT). Elements stay individually freeable. Returns
+// count, or <0 with every out[i] NULL. ta_free_batch unmaps adjacent ranges together.
+int   ta_alloc_batch(unsigned count, const unsigned long long* sizes, const ta_hint_t* hints, void** out);
+void  ta_free_batch(void* const* ptrs, unsigned count);
 
 // Advisory + info
 int   ta_tier_of(const void* p, ta_tier_t* out_tier);
-int   ta_advise(void* p, ta_hint_t hint); // P0: no-op placeholder
+// Re-tier in place (pages migrate, pointer kept); 0 on success. A concurrent ta_free
+// of p waits for it. If the kernel cannot move the pages they are copied instead, and
+// writes to p during that copy are lost: don't write p while ta_advise runs on it.
+int   ta_advise(void* p, ta_hint_t hint);
 
 // Throttled "migration" primitive (returns new ptr; old ptr invalid after)
 void* ta_move(void* p, ta_tier_t dst_tier);
 
+// Bulk copy into dst_tier memory: non-temporal vector stores, split across pool
+// threads pinned to the tier's node for large n (TA_COPY selects the kernel)
+void  ta_copy(void* dst, const void* src, unsigned long long n, ta_tier_t dst_tier);
+
 // Stats
 void  ta_get_stats(ta_stats_snapshot_t* out);
 int   ta_stats_json(char* buf, unsigned long long n);
 
+// Per-node bandwidth/latency microbenchmarks; writes the config file read at init
+// (path NULL: $TA_CONFIG or /etc/tieralloc.conf). Returns 0 on success, -3 if
+// placement is simulated (no libnuma backend), other <0 if nothing was measured.
+int   ta_calibrate(const char* path);
+
 // Utility probe
 const char* ta_hello(void);
 
+// --- Runtime configuration ---
+// Thread-safe; allocations pick up a change on their next policy decision (cap
+// reads are lock-free). Environment values are the starting point. Setters
+// return 0, or -1 on invalid arguments.
+int   ta_get_caps(ta_caps_t* out);
+int   ta_set_caps(const ta_caps_t* caps);
+int   ta_set_node_cap(int node, unsigned long long hard);   // TA_NODE_CAPS entry, 0 = uncapped
+int   ta_get_tier_cfg(ta_tier_t tier, ta_tier_cfg_t* out);
+int   ta_set_tier_cfg(ta_tier_t tier, const ta_tier_cfg_t* cfg); // bandwidth > 0, latency >= 0
+unsigned long long ta_config_version(void);                 // bumps on every cap change
+
+// Serve `tierallocctl ctl` on a UNIX socket (TA_CTL_SOCKET=<path> at init does the
+// same). The socket is created owner-only. A stale socket at path is replaced; a live
+// one or any other file is left alone (-4). Returns 0, or <0 if it cannot listen.
+int   ta_ctl_listen(const char* path);
+
+// --- Accounting domains ---
+// Per-tenant tier budgets inside one process. Allocations (ta_alloc*, interposed
+// malloc) charge the calling thread's current domain, and frees credit the domain
+// that allocated. A domain over its caps routes to other tiers like the process
+// caps do (TA_DOMAIN_ROUTE). With TA_DOMAIN_DEMOTE, it first demotes its own oldest
+// allocations in that tier. Either way, other domains' memory is never touched.
+#define TA_MAX_DOMAINS 64
+typedef int ta_domain_t;   // 0: default domain
+
+typedef enum { TA_DOMAIN_ROUTE = 0, TA_DOMAIN_DEMOTE = 1 } ta_domain_action_t;
+
+typedef struct {
+    unsigned long long soft[3];   // per tier, 0 = uncapped
+    unsigned long long hard[3];
+    int on_hardcap;               // ta_domain_action_t
+} ta_domain_caps_t;
+
+ta_domain_t ta_domain_create(const char* name, const ta_domain_caps_t* caps); // <0 when full
+int   ta_domain_destroy(ta_domain_t d);                     // -2 while it still holds memory
+int   ta_domain_set_caps(ta_domain_t d, const ta_domain_caps_t* caps);
+ta_domain_t ta_domain_set_current(ta_domain_t d);           // this thread; returns previous
+ta_domain_t ta_domain_current(void);
+int   ta_domain_get_stats(ta_domain_t d, ta_stats_snapshot_t* out);
+const char* ta_domain_name(ta_domain_t d);
+
+// --- Regions ---
+// Bump-pointer scratch memory for data that lives one iteration. Chunks come from
+// ta_alloc_ex(reserve, tier, flags) (e.g. TA_ALLOC_HUGEPAGE | TA_ALLOC_POPULATE) and
+// grow on demand; reset rewinds to the first chunk in O(1) and keeps every page
+// resident. A region has a single owner: calls on one region must not race.
+typedef struct ta_region ta_region_t;
+
+ta_region_t* ta_region_create(ta_tier_t tier, unsigned long long reserve, unsigned flags);
+void* ta_region_alloc(ta_region_t* r, unsigned long long bytes, unsigned long long align); // align 0: 16
+void  ta_region_reset(ta_region_t* r);
+void  ta_region_destroy(ta_region_t* r);
+void  ta_region_usage(const ta_region_t* r, unsigned long long* used, unsigned long long* reserved);
+
+// --- Paged KV cache ---
+// Fixed-size blocks in one arena whose pages are spread over the tiers (at most
+// blocks[t] resident in tier t). Sequences own block tables; blocks are refcounted
+// so forks share prefixes. Block addresses never change: tier moves migrate pages
+// in place, so views over a block stay valid. Recently touched sequences are pulled
+// toward FAST, displacing the least recently used blocks one tier down.
+typedef struct ta_kv ta_kv_t;
+
+typedef struct {
+    unsigned long long block_bytes;   // rounded up to whole pages
+    unsigned blocks[3];               // per-tier residency limit, in blocks
+} ta_kv_cfg_t;
+
+typedef struct {
+    unsigned blocks_used[3];
+    unsigned blocks_cap[3];
+    unsigned blocks_free;
+    unsigned sequences;
+    unsigned long long promotions;
+    unsigned long long demotions;
+    unsigned long long cow_copies;
+} ta_kv_stats_t;
+
+ta_kv_t* ta_kv_create(const ta_kv_cfg_t* cfg);
+void  ta_kv_destroy(ta_kv_t* kv);
+unsigned long long ta_kv_block_bytes(const ta_kv_t* kv);
+void* ta_kv_block_ptr(ta_kv_t* kv, int block);
+int   ta_kv_block_tier(ta_kv_t* kv, int block);                       // ta_tier_t, <0 if free
+int   ta_kv_seq_append(ta_kv_t* kv, long long seq, unsigned nblocks); // new table length, <0 on error
+int   ta_kv_seq_fork(ta_kv_t* kv, long long parent, long long child); // child shares parent's blocks
+int   ta_kv_seq_free(ta_kv_t* kv, long long seq);
+int   ta_kv_seq_blocks(ta_kv_t* kv, long long seq, int* out, unsigned max); // table length
+int   ta_kv_seq_writable(ta_kv_t* kv, long long seq, unsigned idx);   // copy-on-write; block id
+int   ta_kv_touch(ta_kv_t* kv, long long seq);                        // mark recent, promote
+void  ta_kv_get_stats(ta_kv_t* kv, ta_kv_stats_t* out);
+
 #ifdef __cplusplus
 }
 #endif
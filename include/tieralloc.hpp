@@ -0,0 +1,135 @@
+#pragma once
+// Header-only C++ layer over tieralloc.h: STL allocators whose tier is a template
+// parameter (the hint is a compile-time constant, nothing is switched at runtime)
+// and std::pmr memory resources per tier/hint and over regions.
+#include "tieralloc.h"
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+
+namespace ta {
+
+inline constexpr ta_tier_t FAST   = TA_TIER_FAST;
+inline constexpr ta_tier_t NORMAL = TA_TIER_NORMAL;
+inline constexpr ta_tier_t SLOW   = TA_TIER_SLOW;
+
+// Hint that asks the policy for exactly this tier
+constexpr ta_hint_t tier_hint(ta_tier_t tier) noexcept {
+    return tier == TA_TIER_FAST ? TA_HINT_PIN_FAST
+         : tier == TA_TIER_SLOW ? TA_HINT_COLD
+         : TA_HINT_WARM;
+}
+
+namespace detail {
+
+constexpr std::size_t kPage = 4096;
+constexpr std::size_t kHugePage = std::size_t(2) << 20;
+
+// ta_alloc ranges are page aligned; TA_ALLOC_HUGEPAGE ones are 2MB aligned
+inline void* alloc_aligned(std::size_t bytes, std::size_t align, ta_hint_t hint) {
+    void* p = nullptr;
+    if (align <= kPage) p = ta_alloc(bytes, hint);
+    else if (align <= kHugePage) p = ta_alloc_ex(bytes, hint, TA_ALLOC_HUGEPAGE);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+} // namespace detail
+
+// std::vector<float, ta::allocator<float, ta::FAST>> v(n);
+// Every allocate() is its own ta_alloc mapping: meant for large, long-lived buffers.
+template <class T, ta_tier_t Tier>
+struct allocator {
+    using value_type = T;
+    using is_always_equal = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    static constexpr ta_tier_t tier = Tier;
+    static constexpr ta_hint_t hint = tier_hint(Tier);
+
+    template <class U>
+    struct rebind { using other = allocator<U, Tier>; };
+
+    constexpr allocator() noexcept = default;
+    template <class U>
+    constexpr allocator(const allocator<U, Tier>&) noexcept {}
+
+    [[nodiscard]] T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(detail::alloc_aligned(n * sizeof(T), alignof(T), hint));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept { ta_free(p); }
+};
+
+template <class T, class U, ta_tier_t A, ta_tier_t B>
+constexpr bool operator==(const allocator<T, A>&, const allocator<U, B>&) noexcept { return A == B; }
+template <class T, class U, ta_tier_t A, ta_tier_t B>
+constexpr bool operator!=(const allocator<T, A>&, const allocator<U, B>&) noexcept { return A != B; }
+
+template <class T> using fast_allocator   = allocator<T, FAST>;
+template <class T> using normal_allocator = allocator<T, NORMAL>;
+template <class T> using slow_allocator   = allocator<T, SLOW>;
+
+// std::pmr resource for one hint. Like the allocator, every request is a mapping;
+// put a std::pmr::unsynchronized_pool_resource on top for small objects.
+class hint_resource final : public std::pmr::memory_resource {
+ public:
+    explicit constexpr hint_resource(ta_hint_t hint) noexcept : hint_(hint) {}
+    ta_hint_t hint() const noexcept { return hint_; }
+
+ private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        return detail::alloc_aligned(bytes, align, hint_);
+    }
+    void do_deallocate(void* p, std::size_t, std::size_t) override { ta_free(p); }
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override {
+        auto* h = dynamic_cast<const hint_resource*>(&o);
+        return h && h->hint_ == hint_;
+    }
+
+    ta_hint_t hint_;
+};
+
+// Process-wide resources, one per hint / tier
+template <ta_hint_t Hint>
+hint_resource* hint_resource_for() noexcept {
+    static hint_resource r(Hint);
+    return &r;
+}
+
+template <ta_tier_t Tier>
+hint_resource* tier_resource() noexcept {
+    return hint_resource_for<tier_hint(Tier)>();
+}
+
+// std::pmr resource over a ta_region: bump allocation, deallocate is a no-op,
+// reset() releases everything at once. Single owner, like the region itself.
+class region_resource final : public std::pmr::memory_resource {
+ public:
+    region_resource(ta_tier_t tier, std::size_t reserve, unsigned flags = TA_ALLOC_NONE)
+        : r_(ta_region_create(tier, reserve, flags)) {
+        if (!r_) throw std::bad_alloc();
+    }
+    ~region_resource() override { ta_region_destroy(r_); }
+    region_resource(const region_resource&) = delete;
+    region_resource& operator=(const region_resource&) = delete;
+
+    void reset() noexcept { ta_region_reset(r_); }
+    ta_region_t* get() const noexcept { return r_; }
+
+ private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        void* p = ta_region_alloc(r_, bytes, align);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+    ta_region_t* r_;
+};
+
+} // namespace ta
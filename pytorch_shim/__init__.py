@@ -1,32 +1,104 @@
 
-from .tieralloc_shim import enable, disable, hello, set_default_hint
+from .tieralloc_shim import (enable, disable, hello, set_default_hint, empty_cache, memory_stats,
+                             push_hint, pop_hint, tier_of, move, advise, move_async, wait, done,
+                             KVCache)
 
 from contextlib import contextmanager
+import time
 
 @contextmanager
-def fast_tier():
-    prev = "warm"
+def hint(name):
+    # Thread-local and nestable: the enclosing scope's hint is back in effect on exit
+    push_hint(name)
     try:
-        set_default_hint("pin_fast")
         yield
     finally:
-        set_default_hint(prev)  # fallback
+        pop_hint()
+
+def fast_tier():
+    return hint("pin_fast")
 
-@contextmanager
 def hot():
-    prev = "warm"
-    try: 
-        set_default_hint("hot")
-        yield
-    finally: 
-        set_default_hint(prev)
+    return hint("hot")
 
-@contextmanager
 def cold():
-    prev = "warm"
-    try: 
-        set_default_hint("cold")
-        yield
-    finally:
-        set_default_hint(prev)
+    return hint("cold")
+
+
+def _layer_tensors(module):
+    return [t.data for t in module.parameters(recurse=False)] + \
+           [t for t in module.buffers(recurse=False) if t.device.type == "cpu"]
+
+
+class Pipeline:
+    """Forward hooks that keep the next `lookahead` layers promoted to FAST and demote
+    layers once they have run. Moves go through the background worker, so they overlap
+    compute; a layer only waits if its own promotion has not finished yet.
+
+    Layers default to every module owning parameters, in registration order (the
+    execution order of sequential stacks). Promotions stop at `fast_budget` bytes;
+    a layer that does not fit runs from wherever it is."""
+
+    def __init__(self, model, lookahead=1, fast_budget=None, layers=None, demote_to="slow"):
+        if layers is None:
+            layers = [m for m in model.modules() if any(True for _ in m.parameters(recurse=False))]
+        self.layers = list(layers)
+        self.tensors = [_layer_tensors(m) for m in self.layers]
+        self.sizes = [sum(t.untyped_storage().nbytes() for t in ts) for ts in self.tensors]
+        self.lookahead = max(0, int(lookahead))
+        self.fast_budget = fast_budget
+        self.demote_to = demote_to
+        self.pending = {}       # layer index -> promotion ticket
+        self.fast_bytes = 0     # promoted or in flight
+        self.stall_s = 0.0      # time forward waited on promotions
+        self.promotions = 0
+        self.demotions = 0
+        self.handles = []
+        for i, m in enumerate(self.layers):
+            self.handles.append(m.register_forward_pre_hook(lambda mod, args, i=i: self._before(i)))
+            self.handles.append(m.register_forward_hook(lambda mod, args, out, i=i: self._after(i)))
+
+    def _promote(self, i):
+        if i in self.pending or not self.tensors[i]:
+            return
+        if self.fast_budget is not None and self.fast_bytes + self.sizes[i] > self.fast_budget:
+            return
+        self.pending[i] = move_async(self.tensors[i], "pin_fast")
+        self.fast_bytes += self.sizes[i]
+        self.promotions += 1
+
+    def _before(self, i):
+        self._promote(i)
+        # Queue the lookahead first so it streams in while this layer computes;
+        # wrap around so the next forward pass starts warm
+        n = len(self.layers)
+        for k in range(1, min(self.lookahead, n - 1) + 1):
+            self._promote((i + k) % n)
+        ticket = self.pending.get(i)
+        if ticket is not None and not done(ticket):
+            t0 = time.perf_counter()
+            wait(ticket)
+            self.stall_s += time.perf_counter() - t0
+
+    def _after(self, i):
+        if self.pending.pop(i, None) is None:
+            return
+        # Runs before any promotion queued later, so the budget holds on the worker too
+        move_async(self.tensors[i], self.demote_to)
+        self.fast_bytes -= self.sizes[i]
+        self.demotions += 1
+
+    def stats(self):
+        return {"layers": len(self.layers), "fast_bytes": self.fast_bytes,
+                "promotions": self.promotions, "demotions": self.demotions,
+                "stall_s": self.stall_s}
+
+    def remove(self):
+        for h in self.handles:
+            h.remove()
+        self.handles = []
+
 
+def pipeline(model, lookahead=1, fast_budget=None, layers=None, demote_to="slow"):
+    return Pipeline(model, lookahead=lookahead, fast_budget=fast_budget, layers=layers,
+                    demote_to=demote_to)
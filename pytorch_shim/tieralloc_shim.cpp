@@ -9,10 +9,19 @@
 
 // Good old C++ libraries
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <optional> 
-#include <string> 
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 // API
 extern "C" {
@@ -20,6 +29,28 @@ extern "C" {
   void ta_init_from_env(void);
   void* ta_alloc(unsigned long long bytes, int hint);
   void ta_free(void* p);
+  int ta_advise(void* p, int hint);
+  int ta_tier_of(const void* p, int* out_tier);
+  void ta_copy(void* dst, const void* src, unsigned long long n, int dst_tier);
+
+  typedef struct ta_kv ta_kv_t;
+  typedef struct { unsigned long long block_bytes; unsigned blocks[3]; } ta_kv_cfg_t;
+  typedef struct {
+    unsigned blocks_used[3]; unsigned blocks_cap[3]; unsigned blocks_free; unsigned sequences;
+    unsigned long long promotions, demotions, cow_copies;
+  } ta_kv_stats_t;
+  ta_kv_t* ta_kv_create(const ta_kv_cfg_t* cfg);
+  void ta_kv_destroy(ta_kv_t* kv);
+  unsigned long long ta_kv_block_bytes(const ta_kv_t* kv);
+  void* ta_kv_block_ptr(ta_kv_t* kv, int block);
+  int ta_kv_block_tier(ta_kv_t* kv, int block);
+  int ta_kv_seq_append(ta_kv_t* kv, long long seq, unsigned nblocks);
+  int ta_kv_seq_fork(ta_kv_t* kv, long long parent, long long child);
+  int ta_kv_seq_free(ta_kv_t* kv, long long seq);
+  int ta_kv_seq_blocks(ta_kv_t* kv, long long seq, int* out, unsigned max);
+  int ta_kv_seq_writable(ta_kv_t* kv, long long seq, unsigned idx);
+  int ta_kv_touch(ta_kv_t* kv, long long seq);
+  void ta_kv_get_stats(ta_kv_t* kv, ta_kv_stats_t* out);
 }
 
 // Map strings
@@ -28,13 +59,334 @@ enum class Hint : int { DEFAULT=0, HOT=1, WARM=2, COLD=3, PIN_FAST=4, PREFER_FAS
 static std::atomic<int> g_default_hint{(int)Hint::WARM};
 static std::atomic<bool> g_enabled{false};
 
-// Context for deleter
-struct TAContext {
+// Nested hint scopes (python: with tieralloc_shim.hint("cold"): ...) are per thread;
+// the process-wide default applies when no scope is open
+static thread_local std::vector<int> t_hint_stack;
+
+static int current_hint() {
+  if (!t_hint_stack.empty()) return t_hint_stack.back();
+  return g_default_hint.load(std::memory_order_relaxed);
+}
+
+static const char* kTierNames[3] = {"fast", "normal", "slow"};
+
+// hot | warm | cold | pin_fast | prefer_fast, plus tier names fast | normal | slow
+static int parse_hint(const std::string& s) {
+  if (s == "hot") return (int)Hint::HOT;
+  if (s == "warm" || s == "normal") return (int)Hint::WARM;
+  if (s == "cold" || s == "slow") return (int)Hint::COLD;
+  if (s == "pin_fast" || s == "fast") return (int)Hint::PIN_FAST;
+  if (s == "prefer_fast") return (int)Hint::PREFER_FAST;
+  if (s == "default") return (int)Hint::DEFAULT;
+  throw std::invalid_argument("tieralloc: unknown hint '" + s + "'");
+}
+
+// Same hint -> tier mapping as the library's policy (FAST=0, NORMAL=1, SLOW=2)
+static int hint_tier(int hint) {
+  switch ((Hint)hint) {
+    case Hint::HOT:
+    case Hint::PIN_FAST:
+    case Hint::PREFER_FAST: return 0;
+    case Hint::COLD:        return 2;
+    default:                return 1;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Caching layer, in the spirit of the CUDA caching allocator: tensors are carved
+// out of large ta_alloc segments kept per tier, split on allocation and merged
+// with free neighbours on release, so most tensor births/deaths never reach
+// mmap/munmap. Block records double as the DataPtr context and are recycled.
+// ---------------------------------------------------------------------------
+namespace cache {
+
+constexpr size_t kAlign        = 512;          // every block is a multiple of this
+constexpr size_t kSmallSize    = 1 << 20;      // <= 1MB comes from the small pool
+constexpr size_t kSmallSegment = 2 << 20;      // small pool grows 2MB at a time
+constexpr size_t kLargeRound   = 2 << 20;      // large segments round up to 2MB
+constexpr size_t kLargeSplit   = 1 << 20;      // keep large remainders >= 1MB only
+
+struct Block {
   void* ptr{nullptr};
-  size_t size{0};
+  size_t size{0};          // bytes owned by this block
+  size_t requested{0};     // bytes the tensor asked for
+  int tier{1};
   int hint{(int)Hint::WARM};
+  bool small{false};
+  bool allocated{false};
+  bool direct{false};      // own ta_alloc mapping, never cached
+  Block* prev{nullptr};    // neighbours inside the same segment
+  Block* next{nullptr};
+};
+
+struct BySize {
+  bool operator()(const Block* a, const Block* b) const {
+    if (a->size != b->size) return a->size < b->size;
+    return (uintptr_t)a->ptr < (uintptr_t)b->ptr;
+  }
+};
+
+struct TierStats {
+  unsigned long long allocated_bytes{0};   // bytes handed to live tensors
+  unsigned long long reserved_bytes{0};    // bytes held in segments
+  unsigned long long segments{0};
+  unsigned long long active_blocks{0};
+  unsigned long long num_allocs{0};
+  unsigned long long num_frees{0};
+  unsigned long long cache_hits{0};        // served without a new segment
+  unsigned long long segment_allocs{0};    // ta_alloc calls
+  unsigned long long segment_frees{0};     // ta_free calls
 };
 
+class CachingAllocator {
+ public:
+  CachingAllocator() {
+    const char* c = std::getenv("TA_SHIM_CACHE");
+    caching_ = !(c && *c == '0');
+    if (const char* m = std::getenv("TA_SHIM_CACHE_MAX_BLOCK")) max_cached_ = std::strtoull(m, nullptr, 10);
+  }
+
+  Block* allocate(size_t nbytes, int hint) {
+    size_t size = round_size(nbytes);
+    int tier = hint_tier(hint);
+    std::scoped_lock lk(mtx_);
+    Block* b = nullptr;
+    if (!caching_ || size > max_cached_) {
+      b = alloc_direct(size, tier, hint);
+    } else {
+      bool small = size <= kSmallSize;
+      auto& pool = pool_for(tier, small);
+      b = take_best_fit(pool, size);
+      if (b) {
+        stats_[tier].cache_hits++;
+      } else {
+        b = new_segment(size, tier, hint, small);
+        if (!b) { release_free_segments(-1); b = new_segment(size, tier, hint, small); }
+        if (!b) return nullptr;
+      }
+      // A new segment may have landed in another tier than the hinted one
+      if (should_split(b, size)) split(b, size, pool_for(b->tier, small));
+    }
+    if (!b) return nullptr;
+    b->allocated = true;
+    b->requested = nbytes;
+    live_[b->ptr] = b;
+    auto& st = stats_[b->tier];
+    st.allocated_bytes += b->size;
+    st.active_blocks++;
+    st.num_allocs++;
+    return b;
+  }
+
+  void free(Block* b) {
+    if (!b) return;
+    std::scoped_lock lk(mtx_);
+    free_locked(b);
+  }
+
+  // Deleter path for raw_deallocate(), which only passes the data pointer.
+  // False if p is not a live block (the caller owns it)
+  bool free_ptr(void* p) {
+    std::scoped_lock lk(mtx_);
+    auto it = live_.find(p);
+    if (it == live_.end()) return false;
+    free_locked(it->second);
+    return true;
+  }
+
+  // Give every fully free segment back to tieralloc
+  void empty_cache() {
+    std::scoped_lock lk(mtx_);
+    release_free_segments(-1);
+  }
+
+  // Re-tier a live block. Direct mappings migrate in place (ta_advise); blocks carved
+  // from a segment cannot, since their neighbours share the segment's tier.
+  // Returns false when the caller has to copy into a new block instead.
+  bool advise_in_place(Block* b, int hint) {
+    int tier = hint_tier(hint);
+    if (tier == b->tier) { std::scoped_lock lk(mtx_); b->hint = hint; return true; }
+    if (!b->direct) return false;
+    // The tensor keeps the block alive, so the migration can run unlocked
+    if (ta_advise(b->ptr, hint) != 0) return false;
+    tier = placed_tier(b->ptr, tier);
+    std::scoped_lock lk(mtx_);
+    if (tier == b->tier) { b->hint = hint; return true; }
+    auto& from = stats_[b->tier];
+    auto& to = stats_[tier];
+    from.allocated_bytes -= b->size; to.allocated_bytes += b->size;
+    from.reserved_bytes -= b->size;  to.reserved_bytes += b->size;
+    from.active_blocks--;            to.active_blocks++;
+    from.segments--;                 to.segments++;
+    b->tier = tier;
+    b->hint = hint;
+    return true;
+  }
+
+  TierStats stats(int tier) {
+    std::scoped_lock lk(mtx_);
+    return stats_[tier];
+  }
+
+ private:
+  static size_t round_size(size_t n) {
+    if (n < kAlign) return kAlign;
+    return (n + kAlign - 1) / kAlign * kAlign;
+  }
+
+  std::set<Block*, BySize>& pool_for(int tier, bool small) {
+    return small ? small_pools_[tier] : large_pools_[tier];
+  }
+
+  Block* new_block() {
+    if (spare_.empty()) return new Block;
+    Block* b = spare_.back();
+    spare_.pop_back();
+    *b = Block{};
+    return b;
+  }
+
+  void recycle(Block* b) { spare_.push_back(b); }
+
+  // Tier tieralloc actually put p in: caps, domains and pressure can route it away
+  // from the hinted one
+  static int placed_tier(const void* p, int hinted) {
+    int actual;
+    return ta_tier_of(p, &actual) == 0 ? actual : hinted;
+  }
+
+  Block* take_best_fit(std::set<Block*, BySize>& pool, size_t size) {
+    Block key;
+    key.size = size;
+    key.ptr = nullptr;
+    auto it = pool.lower_bound(&key);
+    if (it == pool.end()) return nullptr;
+    Block* b = *it;
+    pool.erase(it);
+    return b;
+  }
+
+  Block* new_segment(size_t size, int tier, int hint, bool small) {
+    size_t seg = small ? kSmallSegment : (size + kLargeRound - 1) / kLargeRound * kLargeRound;
+    void* p = ta_alloc((unsigned long long)seg, hint);
+    if (!p) return nullptr;
+    tier = placed_tier(p, tier);
+    Block* b = new_block();
+    b->ptr = p; b->size = seg; b->tier = tier; b->hint = hint; b->small = small;
+    auto& st = stats_[tier];
+    st.reserved_bytes += seg;
+    st.segments++;
+    st.segment_allocs++;
+    return b;
+  }
+
+  Block* alloc_direct(size_t size, int tier, int hint) {
+    void* p = ta_alloc((unsigned long long)size, hint);
+    if (!p) return nullptr;
+    tier = placed_tier(p, tier);
+    Block* b = new_block();
+    b->ptr = p; b->size = size; b->tier = tier; b->hint = hint; b->direct = true;
+    auto& st = stats_[tier];
+    st.reserved_bytes += size;
+    st.segments++;
+    st.segment_allocs++;
+    return b;
+  }
+
+  static bool should_split(const Block* b, size_t size) {
+    size_t rem = b->size - size;
+    return b->small ? rem >= kAlign : rem >= kLargeSplit;
+  }
+
+  void split(Block* b, size_t size, std::set<Block*, BySize>& pool) {
+    Block* rest = new_block();
+    rest->ptr = static_cast<char*>(b->ptr) + size;
+    rest->size = b->size - size;
+    rest->tier = b->tier; rest->hint = b->hint; rest->small = b->small;
+    rest->prev = b;
+    rest->next = b->next;
+    if (b->next) b->next->prev = rest;
+    b->next = rest;
+    b->size = size;
+    pool.insert(rest);
+  }
+
+  void free_locked(Block* b) {
+    if (!b->allocated) return;
+    live_.erase(b->ptr);
+    auto& st = stats_[b->tier];
+    st.allocated_bytes -= b->size;
+    st.active_blocks--;
+    st.num_frees++;
+    b->allocated = false;
+    if (b->direct) {
+      ta_free(b->ptr);
+      st.reserved_bytes -= b->size;
+      st.segments--;
+      st.segment_frees++;
+      recycle(b);
+      return;
+    }
+    auto& pool = pool_for(b->tier, b->small);
+    // Absorb free neighbours so segments can become whole again
+    if (b->prev && !b->prev->allocated) {
+      Block* p = b->prev;
+      pool.erase(p);
+      p->size += b->size;
+      p->next = b->next;
+      if (b->next) b->next->prev = p;
+      recycle(b);
+      b = p;
+    }
+    if (b->next && !b->next->allocated) {
+      Block* n = b->next;
+      pool.erase(n);
+      b->size += n->size;
+      b->next = n->next;
+      if (n->next) n->next->prev = b;
+      recycle(n);
+    }
+    pool.insert(b);
+  }
+
+  // tier < 0: all tiers
+  void release_free_segments(int tier) {
+    for (int t = 0; t < 3; ++t) {
+      if (tier >= 0 && t != tier) continue;
+      for (auto* pool : {&small_pools_[t], &large_pools_[t]}) {
+        for (auto it = pool->begin(); it != pool->end();) {
+          Block* b = *it;
+          if (b->prev || b->next) { ++it; continue; }
+          it = pool->erase(it);
+          ta_free(b->ptr);
+          auto& st = stats_[t];
+          st.reserved_bytes -= b->size;
+          st.segments--;
+          st.segment_frees++;
+          recycle(b);
+        }
+      }
+    }
+  }
+
+  std::mutex mtx_;
+  bool caching_{true};
+  size_t max_cached_{256ull << 20};   // bigger requests get their own mapping
+  std::set<Block*, BySize> small_pools_[3];
+  std::set<Block*, BySize> large_pools_[3];
+  std::unordered_map<void*, Block*> live_;
+  std::vector<Block*> spare_;          // recycled Block records (DataPtr contexts)
+  TierStats stats_[3];
+};
+
+// Leaked on purpose: tensors may still be released during interpreter teardown
+static CachingAllocator& instance() {
+  static CachingAllocator* c = new CachingAllocator;
+  return *c;
+}
+
+} // namespace cache
+
 // Implement at::Allocator
 struct TierAllocAllocator final : at::Allocator {
   at::DataPtr allocate(size_t nbytes) const override {
@@ -44,32 +396,42 @@ struct TierAllocAllocator final : at::Allocator {
       return {p, p, &TierAllocAllocator::raw_delete_fallback, at::Device(at::kCPU)};
     }
 
-    // Choose hint
-    int hint = g_default_hint.load(std::memory_order_relaxed);
+    // Innermost hint scope of this thread, else the process default
+    int hint = current_hint();
+
+    // Served from the per-tier cache; falls back to ta_alloc on a miss
+    cache::Block* b = cache::instance().allocate(nbytes, hint);
+    if (!b) AT_ERROR("tieralloc: allocation failed for ", nbytes, "bytes");
 
-    // call to allocator
-    void* p = ta_alloc((unsigned long long)nbytes, hint);
-    if (!p) AT_ERROR("tieralloc: allocation failed for ", nbytes, "bytes");
+    return wrap(b);
+  }
 
-    // Allocate context for deleter
-    auto* ctx = new TAContext{p, nbytes, hint};
+  // Block record is the deleter context
+  static at::DataPtr wrap(cache::Block* b) {
+    return {b->ptr, (void*)b, &TierAllocAllocator::raw_delete_tieralloc, at::Device(at::kCPU)};
+  }
 
-    // Return a DataPtr with custom deleter
-    return {p, (void*)ctx, &TierAllocAllocator::raw_delete_tieralloc, at::Device(at::kCPU)};
+  // Block behind a tensor's storage, nullptr if tieralloc did not allocate it
+  static cache::Block* block_of(const at::Tensor& t) {
+    const at::DataPtr& dp = t.storage().data_ptr();
+    if (dp.get_deleter() != &TierAllocAllocator::raw_delete_tieralloc) return nullptr;
+    return static_cast<cache::Block*>(dp.get_context());
   }
 
   DeleterFnPtr raw_deleter() const override {
-    return &TierAllocAllocator::raw_delete_tieralloc;
+    return &TierAllocAllocator::raw_delete_ptr;
   }
 
   static void raw_delete_tieralloc(void* ctx_void) {
     if (!ctx_void) return;
-    TAContext* ctx = reinterpret_cast<TAContext*>(ctx_void);
-    if (ctx->ptr) {
-      ta_free(ctx->ptr);
-      ctx->ptr = nullptr;
-    }
-    delete ctx;
+    cache::instance().free(reinterpret_cast<cache::Block*>(ctx_void));
+  }
+
+  // raw_allocate()/raw_deallocate() hand back the data pointer, not the context.
+  // While the shim is disabled, allocate() hands out aligned_alloc memory instead
+  static void raw_delete_ptr(void* ptr) {
+    if (!ptr) return;
+    if (!cache::instance().free_ptr(ptr)) free(ptr);
   }
 
   static void raw_delete_fallback(void* ptr) {
@@ -80,6 +442,196 @@ struct TierAllocAllocator final : at::Allocator {
 
 static TierAllocAllocator g_tieralloc;
 
+// ---------------------------------------------------------------------------
+// Per-tensor tier control. Everything works on the tensor's storage, so views
+// sharing it follow along and keep their offsets.
+// ---------------------------------------------------------------------------
+
+static std::optional<std::string> tensor_tier(const at::Tensor& t) {
+  if (!t.defined() || !t.has_storage()) return std::nullopt;
+  cache::Block* b = TierAllocAllocator::block_of(t);
+  if (!b) return std::nullopt;
+  return std::string(kTierNames[b->tier]);
+}
+
+// Copy the storage into a block allocated with `hint` and swap it in; the old block
+// is released when the replaced DataPtr goes out of scope
+static void retier_by_copy(const at::Tensor& t, int hint) {
+  c10::Storage st = t.storage();
+  size_t nbytes = st.nbytes();
+  cache::Block* b = cache::instance().allocate(nbytes, hint);
+  if (!b) AT_ERROR("tieralloc: allocation failed for ", nbytes, "bytes");
+  ta_copy(b->ptr, st.data_ptr().get(), (unsigned long long)nbytes, b->tier);
+  st.set_data_ptr_noswap(TierAllocAllocator::wrap(b));
+}
+
+static void tensor_move(const at::Tensor& t, int hint) {
+  TORCH_CHECK(t.device().is_cpu(), "tieralloc: move() expects a CPU tensor");
+  if (!t.has_storage() || t.storage().nbytes() == 0) return;
+  cache::Block* b = TierAllocAllocator::block_of(t);
+  if (b && b->tier == hint_tier(hint)) return;
+  retier_by_copy(t, hint);
+}
+
+static void tensor_advise(const at::Tensor& t, int hint) {
+  TORCH_CHECK(t.device().is_cpu(), "tieralloc: advise() expects a CPU tensor");
+  if (!t.has_storage() || t.storage().nbytes() == 0) return;
+  cache::Block* b = TierAllocAllocator::block_of(t);
+  if (b && cache::instance().advise_in_place(b, hint)) return;
+  retier_by_copy(t, hint);
+}
+
+// ---------------------------------------------------------------------------
+// Background mover for the layer pipeline: re-tiers batches of tensors off the
+// Python thread so migration overlaps compute. Jobs run in submission order, so a
+// ticket is done once the worker has passed it, and a demotion queued before a
+// promotion frees its FAST bytes first.
+// ---------------------------------------------------------------------------
+class Mover {
+ public:
+  long long submit(std::vector<at::Tensor> tensors, int hint) {
+    std::unique_lock lk(mtx_);
+    if (!worker_.joinable()) worker_ = std::thread([this] { run(); });
+    long long ticket = ++submitted_;
+    jobs_.push_back(Job{ticket, std::move(tensors), hint});
+    cv_.notify_all();
+    return ticket;
+  }
+
+  void wait(long long ticket) {
+    std::unique_lock lk(mtx_);
+    done_cv_.wait(lk, [&] { return completed_ >= ticket; });
+    if (!error_.empty()) {
+      std::string e;
+      e.swap(error_);
+      throw std::runtime_error("tieralloc: background move failed: " + e);
+    }
+  }
+
+  bool done(long long ticket) {
+    std::scoped_lock lk(mtx_);
+    return completed_ >= ticket;
+  }
+
+ private:
+  struct Job {
+    long long ticket;
+    std::vector<at::Tensor> tensors;
+    int hint;
+  };
+
+  void run() {
+    for (;;) {
+      Job job;
+      {
+        std::unique_lock lk(mtx_);
+        cv_.wait(lk, [&] { return !jobs_.empty(); });
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      std::string err;
+      try {
+        for (const auto& t : job.tensors) tensor_advise(t, job.hint);
+      } catch (const std::exception& e) {
+        err = e.what();
+      }
+      // Drop the tensor references before reporting the ticket as done
+      job.tensors.clear();
+      std::scoped_lock lk(mtx_);
+      completed_ = job.ticket;
+      if (!err.empty() && error_.empty()) error_ = err;
+      done_cv_.notify_all();
+    }
+  }
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::condition_variable done_cv_;
+  std::deque<Job> jobs_;
+  std::thread worker_;
+  long long submitted_{0};
+  long long completed_{0};
+  std::string error_;
+};
+
+// Leaked like the cache: the worker may still hold tensors at interpreter teardown
+static Mover& mover() {
+  static Mover* m = new Mover;
+  return *m;
+}
+
+// ---------------------------------------------------------------------------
+// Paged KV cache (ta_kv_*). Block views are plain from_blob tensors; they hold a
+// reference to the cache, and stay valid across tier moves since blocks migrate
+// in place.
+// ---------------------------------------------------------------------------
+class KVCache {
+ public:
+  KVCache(unsigned long long block_bytes, unsigned fast, unsigned normal, unsigned slow) {
+    ta_init_from_env();
+    ta_kv_cfg_t cfg{block_bytes, {fast, normal, slow}};
+    ta_kv_t* kv = ta_kv_create(&cfg);
+    if (!kv) throw std::invalid_argument("tieralloc: bad KV cache configuration");
+    kv_ = std::shared_ptr<ta_kv_t>(kv, ta_kv_destroy);
+  }
+
+  unsigned long long block_bytes() const { return ta_kv_block_bytes(kv_.get()); }
+
+  int append(long long seq, unsigned nblocks) {
+    int n = ta_kv_seq_append(kv_.get(), seq, nblocks);
+    if (n < 0) throw std::runtime_error("tieralloc: KV cache out of blocks");
+    return n;
+  }
+
+  void fork(long long parent, long long child) {
+    if (ta_kv_seq_fork(kv_.get(), parent, child) != 0)
+      throw std::invalid_argument("tieralloc: unknown parent or existing child sequence");
+  }
+
+  void free(long long seq) { ta_kv_seq_free(kv_.get(), seq); }
+
+  void touch(long long seq) {
+    if (ta_kv_touch(kv_.get(), seq) != 0) throw std::invalid_argument("tieralloc: unknown sequence");
+  }
+
+  std::vector<int> blocks(long long seq) {
+    int n = ta_kv_seq_blocks(kv_.get(), seq, nullptr, 0);
+    if (n < 0) throw std::invalid_argument("tieralloc: unknown sequence");
+    std::vector<int> out((size_t)n);
+    ta_kv_seq_blocks(kv_.get(), seq, out.data(), (unsigned)n);
+    return out;
+  }
+
+  int writable(long long seq, unsigned idx) {
+    int b = ta_kv_seq_writable(kv_.get(), seq, idx);
+    if (b < 0) throw std::runtime_error("tieralloc: copy-on-write failed");
+    return b;
+  }
+
+  std::optional<std::string> tier(int block) {
+    int t = ta_kv_block_tier(kv_.get(), block);
+    if (t < 0) return std::nullopt;
+    return std::string(kTierNames[t]);
+  }
+
+  at::Tensor view(int block, at::ScalarType dtype) {
+    void* p = ta_kv_block_ptr(kv_.get(), block);
+    if (!p) throw std::out_of_range("tieralloc: block id out of range");
+    int64_t n = (int64_t)(block_bytes() / c10::elementSize(dtype));
+    auto keep = kv_;
+    return torch::from_blob(p, {n}, [keep](void*) {}, at::TensorOptions().dtype(dtype));
+  }
+
+  ta_kv_stats_t stats() {
+    ta_kv_stats_t s{};
+    ta_kv_get_stats(kv_.get(), &s);
+    return s;
+  }
+
+ private:
+  std::shared_ptr<ta_kv_t> kv_;
+};
+
 // Install as PyTorch CPU allocator
 static void set_as_cpu_allocator() {
   // Initialize
@@ -100,18 +652,104 @@ PYBIND11_MODULE(tieralloc_shim, m) {
     }
   }, "Enable tieralloc as the CPU allocator for tensors");
 
+  m.def("disable", []() {
+    // Tensors already allocated keep their deleters; new ones use the fallback path
+    g_enabled.store(false);
+  }, "Route new tensor allocations back to the aligned_alloc fallback");
+
   m.def("hello", []() {
     return std::string(ta_hello());
   });
 
   m.def("set_default_hint", [](const std::string& s) {
-    int h = (int)Hint::WARM;
-    if (s == "hot") h = (int)Hint::HOT;
-    else if (s == "warm") h = (int)Hint::WARM;
-    else if (s == "cold") h = (int)Hint::COLD;
-    else if (s == "pin_fast") h = (int)Hint::PIN_FAST;
-    else if (s == "prefer_fast") h = (int)Hint::PREFER_FAST;
-    g_default_hint.store(h, std::memory_order_relaxed);
+    g_default_hint.store(parse_hint(s), std::memory_order_relaxed);
   }, "Set default hint for subsequent tensor allocations: hot | warm | cold | pin_fast | prefer_fast");
 
+  m.def("push_hint", [](const std::string& s) {
+    t_hint_stack.push_back(parse_hint(s));
+  }, "Open a hint scope on the calling thread (use the hint() context manager)");
+
+  m.def("pop_hint", []() {
+    if (!t_hint_stack.empty()) t_hint_stack.pop_back();
+  }, "Close the innermost hint scope on the calling thread");
+
+  m.def("tier_of", [](const at::Tensor& t) {
+    return tensor_tier(t);
+  }, "Tier holding a tensor's storage: fast | normal | slow, or None if tieralloc does not own it");
+
+  m.def("move", [](const at::Tensor& t, const std::string& tier) {
+    tensor_move(t, parse_hint(tier));
+  }, "Copy a tensor's storage into another tier (fast | normal | slow, or a hint); views follow");
+
+  m.def("advise", [](const at::Tensor& t, const std::string& hint) {
+    tensor_advise(t, parse_hint(hint));
+  }, "Re-tier a tensor in place: large tensors migrate their pages, cached ones are copied");
+
+  m.def("move_async", [](std::vector<at::Tensor> tensors, const std::string& hint) {
+    return mover().submit(std::move(tensors), parse_hint(hint));
+  }, "Queue tensors for re-tiering (as advise()) on the background worker; returns a ticket");
+
+  m.def("wait", [](long long ticket) {
+    py::gil_scoped_release nogil;
+    mover().wait(ticket);
+  }, "Block until the background worker has finished a ticket");
+
+  m.def("done", [](long long ticket) {
+    return mover().done(ticket);
+  }, "True once the background worker has finished a ticket");
+
+  py::class_<KVCache>(m, "KVCache", "Paged KV-cache block manager with per-tier block limits")
+    .def(py::init<unsigned long long, unsigned, unsigned, unsigned>(),
+         py::arg("block_bytes"), py::arg("fast"), py::arg("normal") = 0, py::arg("slow") = 0)
+    .def_property_readonly("block_bytes", &KVCache::block_bytes)
+    .def("append", &KVCache::append, "Grow a sequence's block table; returns its new length")
+    .def("fork", &KVCache::fork, "New sequence sharing all of the parent's blocks")
+    .def("free", &KVCache::free, "Drop a sequence and release its block references")
+    .def("touch", &KVCache::touch, "Mark a sequence as just used; pulls its blocks toward FAST")
+    .def("blocks", &KVCache::blocks, "Block table of a sequence")
+    .def("writable", &KVCache::writable, "Copy-on-write a shared table entry; returns its block id")
+    .def("tier", &KVCache::tier, "Tier a block currently resides in")
+    .def("view", &KVCache::view, py::arg("block"), py::arg("dtype") = at::kByte,
+         "1-D tensor over a block's memory (no copy)")
+    .def("stats", [](KVCache& kv) {
+      ta_kv_stats_t s = kv.stats();
+      py::dict out;
+      for (int t = 0; t < 3; ++t) {
+        py::dict d;
+        d["used"] = s.blocks_used[t];
+        d["cap"]  = s.blocks_cap[t];
+        out[kTierNames[t]] = d;
+      }
+      out["free"]       = s.blocks_free;
+      out["sequences"]  = s.sequences;
+      out["promotions"] = s.promotions;
+      out["demotions"]  = s.demotions;
+      out["cow_copies"] = s.cow_copies;
+      return out;
+    });
+
+  m.def("empty_cache", []() {
+    cache::instance().empty_cache();
+  }, "Return cached, fully free segments to tieralloc");
+
+  m.def("memory_stats", []() {
+    const char* names[3] = {"fast", "normal", "slow"};
+    py::dict out;
+    for (int t = 0; t < 3; ++t) {
+      cache::TierStats s = cache::instance().stats(t);
+      py::dict d;
+      d["allocated_bytes"] = s.allocated_bytes;
+      d["reserved_bytes"]  = s.reserved_bytes;
+      d["segments"]        = s.segments;
+      d["active_blocks"]   = s.active_blocks;
+      d["num_allocs"]      = s.num_allocs;
+      d["num_frees"]       = s.num_frees;
+      d["cache_hits"]      = s.cache_hits;
+      d["segment_allocs"]  = s.segment_allocs;
+      d["segment_frees"]   = s.segment_frees;
+      out[names[t]] = d;
+    }
+    return out;
+  }, "Per-tier caching allocator counters (bytes in use, bytes reserved, hits, segment calls)");
+
 }
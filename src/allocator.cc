@@ -1,33 +1,249 @@
 #include "tieralloc.h"
+#include "numa_probe.h"
 
 #include <sys/mman.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <condition_variable>
 #include <unordered_map>
 #include <mutex>
+#include <utility>
+#include <vector>
 #include <new>
 
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
 extern "C" void ta_set_default_config(void); 
+extern "C" int  __ta_config_load(void);
+extern "C" int  __ta_shared_init(void);
+extern "C" int  __ta_pressure_init(void);
+extern "C" int  __ta_ctl_init(void);
+extern "C" void __ta_config_apply(void);
+extern "C" int __ta_policy_pick_tier(unsigned long long bytes, ta_hint_t hint);
+extern "C" int __ta_policy_pick_tier_in(unsigned long long bytes, ta_hint_t hint, int domain);
 extern "C" ta_tier_t __ta_pick_tier_from_hint(ta_hint_t hint);
+extern "C" unsigned long long __ta_domain_demote_need(int d, int t, unsigned long long bytes);
+extern "C" void __ta_domain_add_alloc(int d, ta_tier_t t, unsigned long long calls, unsigned long long sz, long wait_ns);
+extern "C" void __ta_domain_add_free(int d, ta_tier_t t, unsigned long long calls, unsigned long long sz);
+extern "C" void __ta_domain_move(int d, ta_tier_t from, ta_tier_t to, unsigned long long sz);
+extern "C" int __ta_policy_pick_node(unsigned long long bytes, ta_tier_t tier);
 extern "C" void __ta_add_alloc(ta_tier_t, unsigned long long, long);
 extern "C" void __ta_add_free(ta_tier_t, unsigned long long);
+extern "C" void __ta_add_alloc_n(ta_tier_t, unsigned long long, unsigned long long, long);
+extern "C" void __ta_add_free_n(ta_tier_t, unsigned long long, unsigned long long);
+extern "C" void __ta_move_tier(ta_tier_t, ta_tier_t, unsigned long long, long);
+extern "C" unsigned long long __ta_parse_size(const char* s, unsigned long long defv);
+extern "C" bool __ta_place_enabled(void);
+struct ta_placement;
+extern "C" const ta_placement* __ta_tier_placement(ta_tier_t tier);
+extern "C" const ta_placement* __ta_node_placement(int node);
+extern "C" int __ta_placement_home(const ta_placement* pl);
+extern "C" bool __ta_placement_single_node(const ta_placement* pl);
+extern "C" int __ta_place_range(void* p, unsigned long long len, const ta_placement* pl);
+extern "C" void __ta_place_account(const ta_placement* pl, const void* p, unsigned long long len,
+                                   unsigned long long page, int sign);
+extern "C" int __ta_migrate_range(void* p, unsigned long long len, const ta_placement* to, bool exclusive);
+extern "C" void __ta_copy(void* dst, const void* src, unsigned long long n, int dst_node);
+extern "C" unsigned __ta_pool_threads(void);
+extern "C" void __ta_pool_run(int node, unsigned parts, void (*fn)(unsigned, unsigned, void*), void* arg);
+extern "C" void __ta_hook_bypass(int delta);
 
 namespace {
 
+struct Rec;
+struct Link { Rec* prev{nullptr}; Rec* next{nullptr}; };
+
 struct Rec {
     unsigned long long size;
     ta_tier_t tier;
+    const ta_placement* pl;   // node layout the range was placed with
+    int domain;               // accounting domain charged at allocation
+    bool moving{false};       // ta_advise is migrating it; frees wait
+    void* addr{nullptr};
+    unsigned long long page{0};   // page size it faults in (node accounting), 0: base page
+    unsigned long long gen{0};    // tells a record from a later one at the same address
+    Link by_tier, by_domain;  // demotion order, see Fifo
+};
+
+// The map allocates and frees its nodes and buckets under this lock. With TA_INTERPOSE,
+// a thread that called ta_* directly is not inside a hook, so those would come back
+// into ta_alloc/ta_free and relock it; holding it bypasses the hooks instead.
+struct MapMutex {
+    std::mutex m;
+    void lock() { __ta_hook_bypass(+1); m.lock(); }
+    void unlock() { m.unlock(); __ta_hook_bypass(-1); }
 };
 
 std::unordered_map<void*, Rec> g_map;
-std::mutex g_map_mtx;
+MapMutex g_map_mtx;
+std::condition_variable_any g_move_cv;   // a record stopped moving
+
+// Records of one tier (or one domain's share of it) in the order they entered it,
+// longest resident first. Intrusive, so keeping them costs no allocation; map nodes
+// do not move, so the pointers stay valid until the record is erased.
+struct Fifo { Rec* head{nullptr}; Rec* tail{nullptr}; };
+Fifo g_tier_fifo[3];                      // guarded by g_map_mtx
+Fifo g_domain_fifo[TA_MAX_DOMAINS][3];    // guarded by g_map_mtx
+unsigned long long g_gen = 0;             // guarded by g_map_mtx
+
+void fifo_push(Fifo& f, Rec* r, Link Rec::*l) {
+    (r->*l).prev = f.tail;
+    (r->*l).next = nullptr;
+    if (f.tail) (f.tail->*l).next = r; else f.head = r;
+    f.tail = r;
+}
+
+void fifo_erase(Fifo& f, Rec* r, Link Rec::*l) {
+    Link& k = r->*l;
+    if (k.prev) (k.prev->*l).next = k.next; else f.head = k.next;
+    if (k.next) (k.next->*l).prev = k.prev; else f.tail = k.prev;
+    k = Link{};
+}
+
+Fifo& domain_fifo(int d, ta_tier_t t) {
+    return g_domain_fifo[(d >= 0 && d < TA_MAX_DOMAINS) ? d : 0][t];
+}
+
+void untrack(Rec& r) {
+    fifo_erase(g_tier_fifo[r.tier], &r, &Rec::by_tier);
+    fifo_erase(domain_fifo(r.domain, r.tier), &r, &Rec::by_domain);
+}
+
+// Insert a new record for p and queue it in its tier (g_map_mtx held)
+void track(void* p, unsigned long long size, ta_tier_t tier, const ta_placement* pl, int domain,
+           unsigned long long page) {
+    auto [it, fresh] = g_map.try_emplace(p);
+    Rec& r = it->second;
+    if (!fresh) untrack(r);   // stale record for a reused address
+    r = Rec{};
+    r.size = size;
+    r.tier = tier;
+    r.pl = pl;
+    r.domain = domain;
+    r.addr = p;
+    r.page = page;
+    r.gen = ++g_gen;
+    fifo_push(g_tier_fifo[r.tier], &r, &Rec::by_tier);
+    fifo_push(domain_fifo(r.domain, r.tier), &r, &Rec::by_domain);
+}
+
+// Record for p once no migration holds it (g_map_mtx held through lk)
+std::unordered_map<void*, Rec>::iterator find_settled(std::unique_lock<MapMutex>& lk, void* p) {
+    auto it = g_map.find(p);
+    while (it != g_map.end() && it->second.moving) {
+        g_move_cv.wait(lk);
+        it = g_map.find(p);
+    }
+    return it;
+}
+
+inline unsigned long long page_size() {
+    static const unsigned long long page = (unsigned long long) sysconf(_SC_PAGESIZE);
+    return page;
+}
 
 inline unsigned long long round_up_pages(unsigned long long n) {
-    unsigned long long page = (unsigned long long) sysconf(_SC_PAGESIZE);
+    unsigned long long page = page_size();
     return (n + page - 1) / page * page;
 }
 
+// Default prefault behaviour for plain ta_alloc (TA_PREFAULT / TA_PREFAULT_MIN)
+struct PrefaultDefaults {
+    unsigned flags{TA_ALLOC_NONE};
+    unsigned long long min_bytes{64ull << 20};
+};
+
+const PrefaultDefaults& prefault_defaults() {
+    static const PrefaultDefaults d = []{
+        PrefaultDefaults r;
+        if (const char* m = getenv("TA_PREFAULT")) {
+            if (strcmp(m, "populate") == 0) r.flags = TA_ALLOC_POPULATE;
+            else if (strcmp(m, "parallel") == 0) r.flags = TA_ALLOC_PREFAULT_PARALLEL;
+        }
+        r.min_bytes = __ta_parse_size(getenv("TA_PREFAULT_MIN"), r.min_bytes);
+        return r;
+    }();
+    return d;
+}
+
+constexpr unsigned long long kHugePage = 2ull << 20;
+
+// 2MB-aligned mapping flagged for transparent huge pages (before anything faults it)
+void* map_huge_aligned(unsigned long long sz) {
+    void* raw = mmap(nullptr, sz + kHugePage, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return MAP_FAILED;
+    uintptr_t base = (uintptr_t) raw;
+    uintptr_t aligned = (base + kHugePage - 1) & ~(uintptr_t)(kHugePage - 1);
+    if (aligned > base) munmap(raw, aligned - base);
+    uintptr_t tail = aligned + sz, raw_end = base + sz + kHugePage;
+    if (raw_end > tail) munmap((void*) tail, raw_end - tail);
+    madvise((void*) aligned, sz, MADV_HUGEPAGE);
+    return (void*) aligned;
+}
+
+struct TouchArgs {
+    char* base;
+    unsigned long long len;
+};
+
+// Write one byte per page of this part's stripe so the fault happens here
+void touch_part(unsigned idx, unsigned parts, void* arg) {
+    auto* t = static_cast<TouchArgs*>(arg);
+    unsigned long long page = page_size();
+    unsigned long long npages = t->len / page;
+    unsigned long long lo = npages * idx / parts;
+    unsigned long long hi = npages * (idx + 1) / parts;
+    volatile char* b = t->base;
+    for (unsigned long long i = lo; i < hi; ++i) b[i * page] = 0;
+}
+
+void prefault_parallel(void* p, unsigned long long sz, int node) {
+    const unsigned long long chunk = 16ull << 20; // 16MB per part
+    unsigned threads = __ta_pool_threads();
+    unsigned long long want = (sz + chunk - 1) / chunk;
+    unsigned parts = (unsigned) std::min<unsigned long long>(want, std::max(1u, threads) * 4ull);
+    TouchArgs args{static_cast<char*>(p), sz};
+    __ta_pool_run(node, std::max(1u, parts), touch_part, &args);
+}
+
+// mmap sz bytes laid out by pl, prefaulted as aflags (or the TA_PREFAULT default) asks
+void* map_placed(unsigned long long sz, const ta_placement* pl, unsigned aflags) {
+    const bool huge = (aflags & TA_ALLOC_HUGEPAGE) != 0;
+    if (!(aflags & (TA_ALLOC_POPULATE | TA_ALLOC_PREFAULT_PARALLEL | TA_ALLOC_NO_PREFAULT))) {
+        const auto& d = prefault_defaults();
+        if (sz >= d.min_bytes) aflags |= d.flags;
+    }
+
+    // With real placement, MAP_POPULATE would fault pages before mbind runs
+    bool placing = __ta_place_enabled();
+
+    int prot = PROT_READ | PROT_WRITE;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if ((aflags & TA_ALLOC_POPULATE) && !(aflags & TA_ALLOC_PREFAULT_PARALLEL) && !placing && !huge)
+        flags |= MAP_POPULATE;
+    void* p = huge ? map_huge_aligned(sz) : mmap(nullptr, sz, prot, flags, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+
+    // Policy must be in place before the first touch
+    if (placing) __ta_place_range(p, sz, pl);
+
+    if (aflags & TA_ALLOC_PREFAULT_PARALLEL) {
+        prefault_parallel(p, sz, __ta_placement_home(pl));
+    } else if ((aflags & TA_ALLOC_POPULATE) && (placing || huge)) {
+        if (madvise(p, sz, MADV_POPULATE_WRITE) != 0) {
+            TouchArgs args{static_cast<char*>(p), sz};
+            touch_part(0, 1, &args);
+        }
+    }
+    return p;
+}
+
 } 
 
 extern "C" int __ta_internal_get_size(const void* p, unsigned long long* out_size) {
@@ -40,8 +256,11 @@ extern "C" int __ta_internal_get_size(const void* p, unsigned long long* out_siz
 }
 
 extern "C" void ta_init_from_env(void) {
-    
+    // Config file and topology are read once; later calls only reset the throttle model
+    static std::once_flag numa_once;
+    std::call_once(numa_once, []{ __ta_config_load(); ta_numa_init_from_env(); __ta_shared_init(); __ta_pressure_init(); __ta_ctl_init(); });
     ta_set_default_config();
+    __ta_config_apply();
 }
 
 extern "C" const char* ta_hello(void) {
@@ -49,7 +268,121 @@ extern "C" const char* ta_hello(void) {
 }
 
 extern "C" void* ta_alloc(unsigned long long bytes, ta_hint_t hint) {
-    ta_tier_t tier = __ta_pick_tier_from_hint(hint);
+    return ta_alloc_ex(bytes, hint, TA_ALLOC_NONE);
+}
+
+namespace {
+
+// End a move: requeue p's record if its tier changed and let waiting frees proceed
+void settle(void* p, ta_tier_t tier, const ta_placement* pl) {
+    {
+        std::scoped_lock lk(g_map_mtx);
+        auto it = g_map.find(p);
+        Rec& r = it->second;
+        if (r.tier != tier) {
+            // Queue it behind what is already in its new tier
+            untrack(r);
+            r.tier = tier;
+            fifo_push(g_tier_fifo[tier], &r, &Rec::by_tier);
+            fifo_push(domain_fifo(r.domain, tier), &r, &Rec::by_domain);
+        }
+        r.pl = pl;
+        r.moving = false;
+    }
+    g_move_cv.notify_all();
+}
+
+// Move p, whose record rec the caller marked moving, where hint now sends it, and
+// settle it. Only exclusive callers (see __ta_migrate_range) may get the copy fallback.
+// Returns 0 (tier reached in *reached), -3 if the pages did not move, -4 at hard caps.
+int move_claimed(void* p, const Rec& rec, ta_hint_t hint, bool exclusive, ta_tier_t* reached) {
+    *reached = rec.tier;
+    int picked = __ta_policy_pick_tier_in(rec.size, hint, rec.domain);
+    if (picked < 0) { settle(p, rec.tier, rec.pl); return -4; }
+    ta_tier_t dst = (ta_tier_t)picked;
+    int node = __ta_policy_pick_node(rec.size, dst);
+    const ta_placement* pl = (node >= 0) ? __ta_node_placement(node) : __ta_tier_placement(dst);
+    if (dst == rec.tier && pl == rec.pl) { settle(p, rec.tier, rec.pl); return 0; }
+
+    // Charge read from src, write to dst
+    ta_charge_info_t info{0};
+    (void) ta_charge_bytes(rec.tier, rec.size, &info);
+    (void) ta_charge_bytes(dst, rec.size, &info);
+
+    if (__ta_migrate_range(p, rec.size, pl, exclusive) < 0) { settle(p, rec.tier, rec.pl); return -3; }
+
+    settle(p, dst, pl);
+    __ta_move_tier(rec.tier, dst, rec.size, info.simulated_wait_ns);
+    __ta_domain_move(rec.domain, rec.tier, dst, rec.size);
+    __ta_place_account(rec.pl, p, rec.size, rec.page, -1);
+    __ta_place_account(pl, p, rec.size, rec.page, +1);
+    *reached = dst;
+    return 0;
+}
+
+// Make `need` bytes of room in tier t by moving its longest resident allocations one
+// tier down (in place): only domain d's, or any domain's if d < 0, and only ranges
+// placed on `node` if node >= 0. Returns bytes moved.
+// Candidates are taken off the head of the tier's Fifo into a fixed buffer, a bounded
+// batch at a time, so the lock is never held for a long scan or an allocation. Their
+// owners may be writing to them, so only the kernel moves pages; a range it will not
+// move stays put.
+unsigned long long demote_oldest(int d, ta_tier_t t, int node, unsigned long long need) {
+    if (t == TA_TIER_SLOW) return 0;
+    const ta_hint_t down = (t == TA_TIER_FAST) ? TA_HINT_WARM : TA_HINT_COLD;
+    unsigned long long freed = 0;
+    while (freed < need) {
+        struct { void* p; unsigned long long gen; } batch[64];
+        int n = 0;
+        {
+            std::scoped_lock lk(g_map_mtx);
+            Rec* r = (d < 0) ? g_tier_fifo[t].head : domain_fifo(d, t).head;
+            unsigned long long picked = 0;
+            for (int seen = 0; r && n < 64 && picked < need - freed && seen < 4096;
+                 r = (d < 0) ? r->by_tier.next : r->by_domain.next, ++seen) {
+                if (r->moving || (node >= 0 && __ta_placement_home(r->pl) != node)) continue;
+                batch[n++] = {r->addr, r->gen};
+                picked += r->size;
+            }
+        }
+        // Anything that would not move stays at the head; stop instead of retrying it
+        unsigned long long moved = 0;
+        for (int i = 0; i < n; ++i) {
+            Rec rec{};
+            {
+                // Freed, reused, moved or already moving since it was picked: skip it
+                std::scoped_lock lk(g_map_mtx);
+                auto it = g_map.find(batch[i].p);
+                if (it == g_map.end() || it->second.gen != batch[i].gen || it->second.moving ||
+                    it->second.tier != t)
+                    continue;
+                it->second.moving = true;
+                rec = it->second;
+            }
+            ta_tier_t now = t;
+            if (move_claimed(batch[i].p, rec, down, false, &now) == 0 && now != t) moved += rec.size;
+        }
+        if (moved == 0) break;
+        freed += moved;
+    }
+    return freed;
+}
+
+// A demoting domain over its cap first clears room among its own allocations
+void make_domain_room(int domain, ta_hint_t hint, unsigned long long bytes) {
+    ta_tier_t want = __ta_pick_tier_from_hint(hint);
+    if (unsigned long long need = __ta_domain_demote_need(domain, want, bytes))
+        demote_oldest(domain, want, -1, need);
+}
+
+void* alloc_in(unsigned long long bytes, ta_hint_t hint, unsigned aflags, int domain) {
+    make_domain_room(domain, hint, round_up_pages(bytes));
+
+    // Hint + caps pick the tier; locality mode may pin it to a node near the caller
+    int picked = __ta_policy_pick_tier_in(bytes, hint, domain);
+    if (picked < 0) return nullptr;   // every tier at its hard cap, TA_ON_HARDCAP=fail
+    ta_tier_t tier = (ta_tier_t)picked;
+    int node = __ta_policy_pick_node(bytes, tier);
 
     // Simulate cost before allocation
     ta_charge_info_t info{0};
@@ -57,34 +390,179 @@ extern "C" void* ta_alloc(unsigned long long bytes, ta_hint_t hint) {
     (void)wait_ns; 
 
     unsigned long long sz = round_up_pages(bytes);
-    int prot = PROT_READ | PROT_WRITE;
-    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
-    void* p = mmap(nullptr, sz, prot, flags, -1, 0);
-    if (p == MAP_FAILED) return nullptr;
+    if (aflags & TA_ALLOC_HUGEPAGE) sz = (sz + kHugePage - 1) / kHugePage * kHugePage;
+
+    const ta_placement* pl = (node >= 0) ? __ta_node_placement(node) : __ta_tier_placement(tier);
+    void* p = map_placed(sz, pl, aflags);
+    if (!p) return nullptr;
+    const unsigned long long page = (aflags & TA_ALLOC_HUGEPAGE) ? kHugePage : 0;
 
     {
         std::scoped_lock lk(g_map_mtx);
-        g_map[p] = Rec{sz, tier};
+        track(p, sz, tier, pl, domain, page);
     }
 
     __ta_add_alloc(tier, sz, info.simulated_wait_ns);
+    __ta_domain_add_alloc(domain, tier, 1, sz, info.simulated_wait_ns);
+    __ta_place_account(pl, p, sz, page, +1);
     return p;
 }
 
+} // namespace
+
+// Pressure monitor: move up to `need` bytes placed on a node that is short of free
+// memory one tier down
+extern "C" unsigned long long __ta_demote_tier(int tier, int node, unsigned long long need) {
+    if (tier < TA_TIER_FAST || tier > TA_TIER_SLOW) return 0;
+    return demote_oldest(-1, (ta_tier_t)tier, node, need);
+}
+
+extern "C" void* ta_alloc_ex(unsigned long long bytes, ta_hint_t hint, unsigned aflags) {
+    return alloc_in(bytes, hint, aflags, ta_domain_current());
+}
+
 extern "C" void ta_free(void* p) {
     if (!p) return;
     Rec rec{};
     {
-        std::scoped_lock lk(g_map_mtx);
-        auto it = g_map.find(p);
+        std::unique_lock lk(g_map_mtx);
+        auto it = find_settled(lk, p);
         if (it == g_map.end()) { 
             return;
         }
         rec = it->second;
+        untrack(it->second);
         g_map.erase(it);
     }
     munmap(p, rec.size);
     __ta_add_free(rec.tier, rec.size);
+    __ta_domain_add_free(rec.domain, rec.tier, 1, rec.size);
+    __ta_place_account(rec.pl, p, rec.size, rec.page, -1);
+}
+
+// One policy decision, throttle charge and mapping per hint group; every element
+// still gets its own page-aligned range and record, so ta_free works on any of them
+extern "C" int ta_alloc_batch(unsigned count, const unsigned long long* sizes, const ta_hint_t* hints, void** out) {
+    if (!sizes || !out) return -1;
+    for (unsigned i = 0; i < count; ++i) out[i] = nullptr;
+    if (count == 0) return 0;
+
+    constexpr int kHints = TA_HINT_PREFER_FAST + 1;
+    const int domain = ta_domain_current();
+    auto hint_at = [&](unsigned i) {
+        int h = hints ? (int)hints[i] : (int)TA_HINT_DEFAULT;
+        return (h >= 0 && h < kHints) ? h : (int)TA_HINT_DEFAULT;
+    };
+    unsigned long long group_bytes[kHints]{};
+    for (unsigned i = 0; i < count; ++i) group_bytes[hint_at(i)] += round_up_pages(sizes[i] ? sizes[i] : 1);
+
+    // Striped placements lay out pages relative to the mapping start, so elements
+    // are only carved from a shared mapping when the group lands on a single node
+    struct Group {
+        char* base;                 // shared mapping, nullptr if mapped per element
+        ta_tier_t tier;
+        const ta_placement* pl;
+        long wait_ns;
+        unsigned long long cursor;
+    };
+    Group groups[kHints]{};
+    auto unwind = [&](unsigned upto) {
+        for (unsigned i = 0; i < upto; ++i)
+            if (out[i] && !groups[hint_at(i)].base) munmap(out[i], round_up_pages(sizes[i] ? sizes[i] : 1));
+        for (int h = 0; h < kHints; ++h)
+            if (groups[h].base) munmap(groups[h].base, group_bytes[h]);
+        for (unsigned i = 0; i < count; ++i) out[i] = nullptr;
+    };
+    for (int h = 0; h < kHints; ++h) {
+        if (!group_bytes[h]) continue;
+        const unsigned long long total = group_bytes[h];
+        make_domain_room(domain, (ta_hint_t)h, total);
+        int picked = __ta_policy_pick_tier_in(total, (ta_hint_t)h, domain);
+        if (picked < 0) { unwind(0); return -3; }
+        ta_tier_t tier = (ta_tier_t)picked;
+        int node = __ta_policy_pick_node(total, tier);
+        ta_charge_info_t info{0};
+        (void) ta_charge_bytes(tier, total, &info);
+        const ta_placement* pl = (node >= 0) ? __ta_node_placement(node) : __ta_tier_placement(tier);
+        groups[h] = Group{nullptr, tier, pl, info.simulated_wait_ns, 0};
+        if (!__ta_placement_single_node(pl)) continue;
+        void* p = map_placed(total, pl, TA_ALLOC_NONE);
+        if (!p) { unwind(0); return -2; }
+        groups[h].base = static_cast<char*>(p);
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        Group& g = groups[hint_at(i)];
+        unsigned long long sz = round_up_pages(sizes[i] ? sizes[i] : 1);
+        if (g.base) {
+            out[i] = g.base + g.cursor;
+            g.cursor += sz;
+        } else {
+            out[i] = map_placed(sz, g.pl, TA_ALLOC_NONE);
+            if (!out[i]) { unwind(i); return -2; }
+        }
+    }
+
+    {
+        std::scoped_lock lk(g_map_mtx);
+        g_map.reserve(g_map.size() + count);
+        for (unsigned i = 0; i < count; ++i) {
+            const Group& g = groups[hint_at(i)];
+            track(out[i], round_up_pages(sizes[i] ? sizes[i] : 1), g.tier, g.pl, domain, 0);
+        }
+    }
+
+    unsigned calls[kHints]{};
+    for (unsigned i = 0; i < count; ++i) calls[hint_at(i)]++;
+    for (int h = 0; h < kHints; ++h) {
+        if (!group_bytes[h]) continue;
+        __ta_add_alloc_n(groups[h].tier, calls[h], group_bytes[h], groups[h].wait_ns);
+        __ta_domain_add_alloc(domain, groups[h].tier, calls[h], group_bytes[h], groups[h].wait_ns);
+        if (groups[h].base) __ta_place_account(groups[h].pl, groups[h].base, group_bytes[h], 0, +1);
+    }
+    for (unsigned i = 0; i < count; ++i)
+        if (!groups[hint_at(i)].base)
+            __ta_place_account(groups[hint_at(i)].pl, out[i], round_up_pages(sizes[i] ? sizes[i] : 1), 0, +1);
+    return (int)count;
+}
+
+// Frees under one lock; address-adjacent ranges (e.g. from one batch) share a munmap
+extern "C" void ta_free_batch(void* const* ptrs, unsigned count) {
+    if (!ptrs || count == 0) return;
+    std::vector<std::pair<char*, Rec>> recs;
+    recs.reserve(count);
+    {
+        std::unique_lock lk(g_map_mtx);
+        for (unsigned i = 0; i < count; ++i) {
+            if (!ptrs[i]) continue;
+            auto it = find_settled(lk, ptrs[i]);
+            if (it == g_map.end()) continue;
+            recs.emplace_back(static_cast<char*>(ptrs[i]), it->second);
+            untrack(it->second);
+            g_map.erase(it);
+        }
+    }
+    if (recs.empty()) return;
+    std::sort(recs.begin(), recs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    unsigned long long calls[3]{}, bytes[3]{};
+    char* run = recs[0].first;
+    unsigned long long run_len = 0;
+    for (const auto& [p, rec] : recs) {
+        if (p != run + run_len) {
+            munmap(run, run_len);
+            run = p;
+            run_len = 0;
+        }
+        run_len += rec.size;
+        calls[(int)rec.tier]++;
+        bytes[(int)rec.tier] += rec.size;
+        __ta_domain_add_free(rec.domain, rec.tier, 1, rec.size);
+        __ta_place_account(rec.pl, p, rec.size, rec.page, -1);
+    }
+    munmap(run, run_len);
+    for (int t = 0; t < 3; ++t)
+        if (calls[t]) __ta_add_free_n((ta_tier_t)t, calls[t], bytes[t]);
 }
 
 extern "C" int ta_tier_of(const void* p, ta_tier_t* out_tier) {
@@ -96,8 +574,20 @@ extern "C" int ta_tier_of(const void* p, ta_tier_t* out_tier) {
     return 0;
 }
 
-extern "C" int ta_advise(void* /*p*/, ta_hint_t /*hint*/) { 
-    return 0;
+// Re-tier a live allocation in place: pages migrate, the pointer stays valid
+extern "C" int ta_advise(void* p, ta_hint_t hint) {
+    if (!p) return -1;
+    Rec rec{};
+    {
+        // Own the record for the whole move: frees and other advises wait
+        std::unique_lock lk(g_map_mtx);
+        auto it = find_settled(lk, p);
+        if (it == g_map.end()) return -2;
+        it->second.moving = true;
+        rec = it->second;
+    }
+    ta_tier_t reached;
+    return move_claimed(p, rec, hint, true, &reached);
 }
 
 extern "C" void* ta_move(void* p, ta_tier_t dst_tier) {
@@ -116,12 +606,19 @@ extern "C" void* ta_move(void* p, ta_tier_t dst_tier) {
     (void) ta_charge_bytes(dst_tier, rec.size, &info);
 
     // Allocate new region in dst tier
-    void* q = ta_alloc(rec.size, dst_tier == TA_TIER_FAST ? TA_HINT_PIN_FAST :
-                                  dst_tier == TA_TIER_NORMAL ? TA_HINT_WARM : TA_HINT_COLD);
+    void* q = alloc_in(rec.size, dst_tier == TA_TIER_FAST ? TA_HINT_PIN_FAST :
+                                 dst_tier == TA_TIER_NORMAL ? TA_HINT_WARM : TA_HINT_COLD,
+                       TA_ALLOC_NONE, rec.domain);
     if (!q) return nullptr;
 
-    // Copy + free old
-    memcpy(q, p, (size_t)rec.size);
+    // Copy (streamed, by threads near the new pages) + free old
+    int dst_node = -1;
+    {
+        std::scoped_lock lk(g_map_mtx);
+        auto it = g_map.find(q);
+        if (it != g_map.end()) dst_node = __ta_placement_home(it->second.pl);
+    }
+    __ta_copy(q, p, rec.size, dst_node);
     ta_free(p);
     return q;
 }
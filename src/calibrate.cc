@@ -0,0 +1,139 @@
+// Built-in microbenchmarks behind `tierallocctl calibrate`: streaming read bandwidth
+// and dependent-load (pointer chasing) latency for every memory node.
+#include "numa_probe.h"
+#include "tieralloc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <pthread.h>
+#include <sys/mman.h>
+
+extern "C" int __ta_place_node(void* p, unsigned long long len, int node);
+extern "C" bool __ta_place_enabled(void);
+extern "C" unsigned __ta_pool_threads(void);
+extern "C" void __ta_pool_run(int node, unsigned parts, void (*fn)(unsigned, unsigned, void*), void* arg);
+extern "C" const char* __ta_config_path(void);
+extern "C" unsigned long long __ta_parse_size(const char* s, unsigned long long defv);
+
+namespace {
+
+using clk = std::chrono::steady_clock;
+
+void* volatile g_chase_sink;
+
+struct StreamArgs {
+  uint64_t* base;
+  size_t words;
+  std::atomic<uint64_t> sink{0};
+};
+
+void fill_part(unsigned idx, unsigned parts, void* a) {
+  auto* s = static_cast<StreamArgs*>(a);
+  size_t lo = s->words * idx / parts, hi = s->words * (idx + 1) / parts;
+  for (size_t i = lo; i < hi; ++i) s->base[i] = i;
+}
+
+void read_part(unsigned idx, unsigned parts, void* a) {
+  auto* s = static_cast<StreamArgs*>(a);
+  size_t lo = s->words * idx / parts, hi = s->words * (idx + 1) / parts;
+  uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+  size_t i = lo;
+  for (; i + 4 <= hi; i += 4) { a0 += s->base[i]; a1 += s->base[i+1]; a2 += s->base[i+2]; a3 += s->base[i+3]; }
+  for (; i < hi; ++i) a0 += s->base[i];
+  s->sink.fetch_add(a0 + a1 + a2 + a3, std::memory_order_relaxed);
+}
+
+// Best of a few passes, all pool threads reading from CPUs of ref
+double stream_bw(uint64_t* buf, size_t bytes, int ref) {
+  StreamArgs args;
+  args.base = buf;
+  args.words = bytes / sizeof(uint64_t);
+  unsigned parts = std::max(1u, __ta_pool_threads());
+  __ta_pool_run(ref, parts, fill_part, &args);
+  double best = 0.0;
+  for (int rep = 0; rep < 3; ++rep) {
+    auto t0 = clk::now();
+    __ta_pool_run(ref, parts, read_part, &args);
+    double sec = std::chrono::duration<double>(clk::now() - t0).count();
+    if (sec > 0.0) best = std::max(best, (double)bytes / sec);
+  }
+  return best;
+}
+
+// Random cyclic chain over cache lines, one dependent load per step
+long chase_latency_ns(char* buf, size_t bytes) {
+  const size_t line = 64;
+  size_t lines = std::min<size_t>(bytes, 64ull << 20) / line;
+  if (lines < 2) return 0;
+  std::vector<uint32_t> order(lines);
+  for (size_t i = 0; i < lines; ++i) order[i] = (uint32_t)i;
+  std::mt19937_64 rng(0x7a11a110c);
+  for (size_t i = lines - 1; i > 0; --i) {  // Sattolo: a single cycle
+    size_t j = rng() % i;
+    std::swap(order[i], order[j]);
+  }
+  for (size_t i = 0; i < lines; ++i)
+    *reinterpret_cast<void**>(buf + (size_t)order[i] * line) = buf + (size_t)order[(i + 1) % lines] * line;
+
+  const size_t steps = std::max<size_t>(lines * 2, 1u << 22);
+  void* p = buf + (size_t)order[0] * line;
+  for (size_t i = 0; i < lines; ++i) p = *static_cast<void**>(p);  // warm TLB
+  auto t0 = clk::now();
+  for (size_t i = 0; i < steps; ++i) p = *static_cast<void**>(p);
+  double ns = std::chrono::duration<double, std::nano>(clk::now() - t0).count();
+  g_chase_sink = p;  // keep the chain live
+  return (long)(ns / (double)steps + 0.5);
+}
+
+} // namespace
+
+extern "C" int ta_calibrate(const char* out_path) {
+  // Without real placement every "node" would be the same unbound memory
+  if (!__ta_place_enabled()) return -3;
+  const auto& s = ta_numa_probe();
+  const char* path = (out_path && *out_path) ? out_path : __ta_config_path();
+  const unsigned long long bytes = __ta_parse_size(std::getenv("TA_CALIBRATE_BYTES"), 256ull << 20);
+
+  // Measure from the first node with CPUs, the same vantage point the auto tier map uses
+  int ref = 0;
+  cpu_set_t ref_cpus;
+  for (int n = 0; n < s.node_count && n < TA_NUMA_MAX_NODES; ++n)
+    if (ta_numa_node_cpus(n, &ref_cpus)) { ref = n; break; }
+
+  cpu_set_t saved;
+  bool pinned = false;
+  if (pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0 && ta_numa_node_cpus(ref, &ref_cpus))
+    pinned = pthread_setaffinity_np(pthread_self(), sizeof(ref_cpus), &ref_cpus) == 0;
+
+  FILE* f = std::fopen(path, "w");
+  if (!f) {
+    if (pinned) pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    return -1;
+  }
+  std::fprintf(f, "# tieralloc calibration (tierallocctl calibrate)\n");
+  std::fprintf(f, "# streaming read bandwidth and dependent-load latency per node, measured from node %d\n", ref);
+  std::fprintf(f, "# tier.<fast|normal|slow>.bandwidth_Bps / .base_latency_ns override the per-tier figures\n");
+
+  int measured = 0;
+  for (int n = 0; n < s.node_count && n < TA_NUMA_MAX_NODES; ++n) {
+    if (!s.node_mem_bytes[n]) continue;
+    void* buf = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) continue;
+    if (__ta_place_node(buf, bytes, n) != 0) { munmap(buf, bytes); continue; }
+    double bw = stream_bw(static_cast<uint64_t*>(buf), bytes, ref);
+    long lat = chase_latency_ns(static_cast<char*>(buf), bytes);
+    munmap(buf, bytes);
+    std::fprintf(f, "node.%d.bandwidth_Bps = %.4e\n", n, bw);
+    std::fprintf(f, "node.%d.latency_ns = %ld\n", n, lat);
+    measured++;
+  }
+  std::fclose(f);
+  if (pinned) pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+  return measured > 0 ? 0 : -2;
+}
@@ -0,0 +1,126 @@
+// Calibration/config file: per-node bandwidth and latency, optional per-tier overrides.
+//
+//   # comment
+//   node.<id>.bandwidth_Bps = <double>
+//   node.<id>.latency_ns = <long>
+//   tier.<fast|normal|slow>.bandwidth_Bps = <double>
+//   tier.<fast|normal|slow>.base_latency_ns = <long>
+//
+// Read once at init from $TA_CONFIG, else /etc/tieralloc.conf (TA_CONFIG=none skips it).
+#include "numa_probe.h"
+#include "tieralloc.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" void __ta_throttle_set_tier(ta_tier_t tier, double bw_Bps, long base_latency_ns);
+
+namespace {
+
+struct Figures {
+  double bw_Bps{0.0};
+  long lat_ns{0};
+};
+
+struct FileConfig {
+  bool loaded{false};
+  Figures node[TA_NUMA_MAX_NODES];
+  Figures tier[3];
+};
+
+FileConfig g_file;
+
+const char* kTierNames[3] = {"fast", "normal", "slow"};
+
+char* trim(char* s) {
+  while (*s == ' ' || *s == '\t') ++s;
+  char* e = s + std::strlen(s);
+  while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\n' || e[-1] == '\r')) *--e = '\0';
+  return s;
+}
+
+void apply_kv(const char* key, const char* val) {
+  int id = 0;
+  char field[64];
+  if (std::sscanf(key, "node.%d.%63s", &id, field) == 2) {
+    if (id < 0 || id >= TA_NUMA_MAX_NODES) return;
+    if (std::strcmp(field, "bandwidth_Bps") == 0) g_file.node[id].bw_Bps = std::strtod(val, nullptr);
+    else if (std::strcmp(field, "latency_ns") == 0) g_file.node[id].lat_ns = std::strtol(val, nullptr, 10);
+    return;
+  }
+  for (int t = 0; t < 3; ++t) {
+    char prefix[32];
+    std::snprintf(prefix, sizeof(prefix), "tier.%s.", kTierNames[t]);
+    size_t n = std::strlen(prefix);
+    if (std::strncmp(key, prefix, n) != 0) continue;
+    if (std::strcmp(key + n, "bandwidth_Bps") == 0) g_file.tier[t].bw_Bps = std::strtod(val, nullptr);
+    else if (std::strcmp(key + n, "base_latency_ns") == 0) g_file.tier[t].lat_ns = std::strtol(val, nullptr, 10);
+    return;
+  }
+}
+
+} // namespace
+
+// Default location tierallocctl calibrate writes to and the library reads from
+extern "C" const char* __ta_config_path(void) {
+  const char* p = std::getenv("TA_CONFIG");
+  return (p && *p) ? p : "/etc/tieralloc.conf";
+}
+
+// Parse the config file; missing file is not an error
+extern "C" int __ta_config_load(void) {
+  const char* path = __ta_config_path();
+  if (std::strcmp(path, "none") == 0) return 1;
+  FILE* f = std::fopen(path, "r");
+  if (!f) return 1;
+  char line[512];
+  while (std::fgets(line, sizeof(line), f)) {
+    char* s = trim(line);
+    if (!*s || *s == '#') continue;
+    char* eq = std::strchr(s, '=');
+    if (!eq) continue;
+    *eq = '\0';
+    apply_kv(trim(s), trim(eq + 1));
+  }
+  std::fclose(f);
+  g_file.loaded = true;
+  return 0;
+}
+
+// Calibrated figures for a node; -1 if the file had none
+extern "C" int __ta_config_node(int node, double* bw_Bps, long* lat_ns) {
+  if (node < 0 || node >= TA_NUMA_MAX_NODES) return -1;
+  const Figures& f = g_file.node[node];
+  if (f.bw_Bps <= 0.0) return -1;
+  if (bw_Bps) *bw_Bps = f.bw_Bps;
+  if (lat_ns) *lat_ns = f.lat_ns;
+  return 0;
+}
+
+// Feed the throttle model: explicit tier.* entries win; otherwise a tier whose nodes are
+// all calibrated gets their aggregate bandwidth (all nodes for interleaved tiers, the
+// first node otherwise) and the bandwidth-weighted mean latency. Tiers without figures
+// keep ta_set_default_config() values (as does a missing latency, passed as -1).
+extern "C" void __ta_config_apply(void) {
+  if (!g_file.loaded) return;
+  const auto& s = ta_numa_probe();
+  for (int t = 0; t < 3; ++t) {
+    double bw = g_file.tier[t].bw_Bps;
+    long lat = (g_file.tier[t].lat_ns > 0) ? g_file.tier[t].lat_ns : -1;
+    if (bw <= 0.0) {
+      int n = (s.tier_mode[t] == ta_place_mode::preferred) ? 1 : s.tier_nnodes[t];
+      double lat_acc = 0.0;
+      bool all = true;
+      for (int i = 0; i < n; ++i) {
+        const Figures& f = g_file.node[s.tier_nodes[t][i]];
+        if (f.bw_Bps <= 0.0) { all = false; break; }
+        bw += f.bw_Bps;
+        lat_acc += f.bw_Bps * (double)f.lat_ns;
+      }
+      if (!all) bw = 0.0;
+      else if (lat < 0) lat = (long)(lat_acc / bw);
+    }
+    if (bw > 0.0 || lat >= 0) __ta_throttle_set_tier((ta_tier_t)t, bw, lat);
+  }
+}
@@ -0,0 +1,160 @@
+// Tier copy kernel: non-temporal vector stores (runtime-dispatched via CPUID) so demoted
+// data does not pollute the LLC, split across pool threads pinned to the destination node.
+#include "tieralloc.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TA_COPY_X86 1
+#endif
+
+extern "C" int __ta_tier_home_node(ta_tier_t tier);
+extern "C" unsigned __ta_pool_threads(void);
+extern "C" void __ta_pool_run(int node, unsigned parts, void (*fn)(unsigned, unsigned, void*), void* arg);
+extern "C" unsigned long long __ta_parse_size(const char* s, unsigned long long defv);
+
+namespace {
+
+using copy_fn = void (*)(void* dst, const void* src, size_t n);
+
+void copy_memcpy(void* dst, const void* src, size_t n) {
+    std::memcpy(dst, src, n);
+}
+
+#if defined(TA_COPY_X86)
+
+// Each kernel: memcpy up to dst alignment, stream the aligned body, memcpy the tail
+
+void copy_sse2_nt(void* dst, const void* src, size_t n) {
+    auto* d = static_cast<char*>(dst);
+    auto* s = static_cast<const char*>(src);
+    size_t head = std::min(n, (size_t)((16 - ((uintptr_t)d & 15)) & 15));
+    std::memcpy(d, s, head); d += head; s += head; n -= head;
+    for (; n >= 64; n -= 64, d += 64, s += 64) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s +  0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(s + 32));
+        __m128i e = _mm_loadu_si128((const __m128i*)(s + 48));
+        _mm_stream_si128((__m128i*)(d +  0), a);
+        _mm_stream_si128((__m128i*)(d + 16), b);
+        _mm_stream_si128((__m128i*)(d + 32), c);
+        _mm_stream_si128((__m128i*)(d + 48), e);
+    }
+    _mm_sfence();
+    std::memcpy(d, s, n);
+}
+
+__attribute__((target("avx2")))
+void copy_avx2_nt(void* dst, const void* src, size_t n) {
+    auto* d = static_cast<char*>(dst);
+    auto* s = static_cast<const char*>(src);
+    size_t head = std::min(n, (size_t)((32 - ((uintptr_t)d & 31)) & 31));
+    std::memcpy(d, s, head); d += head; s += head; n -= head;
+    for (; n >= 128; n -= 128, d += 128, s += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s +  0));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i*)(s + 64));
+        __m256i e = _mm256_loadu_si256((const __m256i*)(s + 96));
+        _mm256_stream_si256((__m256i*)(d +  0), a);
+        _mm256_stream_si256((__m256i*)(d + 32), b);
+        _mm256_stream_si256((__m256i*)(d + 64), c);
+        _mm256_stream_si256((__m256i*)(d + 96), e);
+    }
+    _mm_sfence();
+    std::memcpy(d, s, n);
+}
+
+__attribute__((target("avx512f")))
+void copy_avx512_nt(void* dst, const void* src, size_t n) {
+    auto* d = static_cast<char*>(dst);
+    auto* s = static_cast<const char*>(src);
+    size_t head = std::min(n, (size_t)((64 - ((uintptr_t)d & 63)) & 63));
+    std::memcpy(d, s, head); d += head; s += head; n -= head;
+    for (; n >= 256; n -= 256, d += 256, s += 256) {
+        __m512i a = _mm512_loadu_si512((const void*)(s +   0));
+        __m512i b = _mm512_loadu_si512((const void*)(s +  64));
+        __m512i c = _mm512_loadu_si512((const void*)(s + 128));
+        __m512i e = _mm512_loadu_si512((const void*)(s + 192));
+        _mm512_stream_si512((__m512i*)(d +   0), a);
+        _mm512_stream_si512((__m512i*)(d +  64), b);
+        _mm512_stream_si512((__m512i*)(d + 128), c);
+        _mm512_stream_si512((__m512i*)(d + 192), e);
+    }
+    _mm_sfence();
+    std::memcpy(d, s, n);
+}
+
+#endif
+
+struct CopyConfig {
+    copy_fn fn{copy_memcpy};
+    const char* name{"memcpy"};
+    unsigned long long nt_min{256ull << 10};   // below this plain memcpy wins
+    unsigned long long par_min{16ull << 20};   // split across the pool above this
+};
+
+// Pick once: TA_COPY=auto|memcpy|sse2|avx2|avx512 (auto = widest the CPU supports)
+const CopyConfig& config() {
+    static const CopyConfig c = []{
+        CopyConfig r;
+        const char* want = std::getenv("TA_COPY");
+        bool any = !want || !*want || std::strcmp(want, "auto") == 0;
+        auto pick = [&](const char* name) { return any || std::strcmp(want, name) == 0; };
+#if defined(TA_COPY_X86)
+        __builtin_cpu_init();
+        if (pick("avx512") && __builtin_cpu_supports("avx512f")) { r.fn = copy_avx512_nt; r.name = "avx512"; }
+        else if (pick("avx2") && __builtin_cpu_supports("avx2")) { r.fn = copy_avx2_nt; r.name = "avx2"; }
+        else if (pick("sse2") && __builtin_cpu_supports("sse2")) { r.fn = copy_sse2_nt; r.name = "sse2"; }
+#else
+        (void)pick;
+#endif
+        r.nt_min = __ta_parse_size(std::getenv("TA_COPY_NT_MIN"), r.nt_min);
+        r.par_min = __ta_parse_size(std::getenv("TA_COPY_PAR_MIN"), r.par_min);
+        return r;
+    }();
+    return c;
+}
+
+struct CopyArgs {
+    char* dst;
+    const char* src;
+    size_t n;
+    copy_fn fn;
+};
+
+// Parts are cut on 4KB boundaries so each thread streams whole pages
+void copy_part(unsigned idx, unsigned parts, void* arg) {
+    auto* a = static_cast<CopyArgs*>(arg);
+    const size_t pages = (a->n + 4095) / 4096;
+    size_t lo = std::min(a->n, pages * idx / parts * 4096);
+    size_t hi = std::min(a->n, pages * (idx + 1) / parts * 4096);
+    if (hi > lo) a->fn(a->dst + lo, a->src + lo, hi - lo);
+}
+
+} // namespace
+
+// Bulk copy into memory living on dst_node (<0: unknown, run unpinned)
+extern "C" void __ta_copy(void* dst, const void* src, unsigned long long n, int dst_node) {
+    if (!dst || !src || n == 0) return;
+    const auto& c = config();
+    if (n < c.nt_min) { std::memcpy(dst, src, (size_t)n); return; }
+    CopyArgs args{static_cast<char*>(dst), static_cast<const char*>(src), (size_t)n, c.fn};
+    unsigned parts = 1;
+    if (n >= c.par_min) {
+        const unsigned long long per_part = 8ull << 20;
+        parts = (unsigned) std::min<unsigned long long>(std::max(1u, __ta_pool_threads()), n / per_part);
+    }
+    __ta_pool_run(dst_node, std::max(1u, parts), copy_part, &args);
+}
+
+extern "C" const char* __ta_copy_kernel_name(void) {
+    return config().name;
+}
+
+extern "C" void ta_copy(void* dst, const void* src, unsigned long long n, ta_tier_t dst_tier) {
+    __ta_copy(dst, src, n, __ta_tier_home_node(dst_tier));
+}
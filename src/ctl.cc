@@ -0,0 +1,285 @@
+// Control plane: a UNIX socket served by one thread, used by `tierallocctl ctl`.
+// One request line per connection, one reply:
+//   stats                                   -> ta_stats_json
+//   caps                                    -> current caps as JSON
+//   caps fast_soft=8G slow_hard=0 on_hardcap=fail node1=16G ...
+//   tier <fast|normal|slow>                 -> throttle figures and soft cap as JSON
+//   tier <fast|normal|slow> bw=20G lat=8000 cap=4G
+// Updates reply "ok version=<n>" or "error: <reason>".
+#include "numa_probe.h"
+#include "tieralloc.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+extern "C" bool __ta_parse_size_strict(const char* s, unsigned long long* out);
+extern "C" int __ta_edit_caps(const ta_caps_t* caps, unsigned mask, const int* nodes,
+                              const unsigned long long* node_hard, int n);
+
+namespace {
+
+struct Listener {
+  std::mutex mtx;
+  int fd{-1};
+  char path[sizeof(sockaddr_un::sun_path)]{};
+  pid_t owner{0};          // the process that bound it
+  dev_t dev{0};            // what it bound, to recognise the path at exit
+  ino_t ino{0};
+  std::atomic<bool> stop{false};
+  std::thread* thr{nullptr};
+};
+
+Listener& L() { static Listener l; return l; }
+
+const char* kTierNames[3] = {"fast", "normal", "slow"};
+
+int tier_from_name(const char* s) {
+  for (int t = 0; t < 3; ++t)
+    if (std::strcmp(s, kTierNames[t]) == 0) return t;
+  return -1;
+}
+
+std::string caps_json() {
+  ta_caps_t c{};
+  ta_get_caps(&c);
+  char buf[512];
+  std::snprintf(buf, sizeof(buf),
+      "{\"version\":%llu,\"soft\":[ %llu, %llu, %llu ],\"hard\":[ %llu, %llu, %llu ],\"on_hardcap\":\"%s\"}",
+      ta_config_version(), c.soft[0], c.soft[1], c.soft[2], c.hard[0], c.hard[1], c.hard[2],
+      c.on_hardcap == TA_HARDCAP_FAIL ? "fail" : "route_slow");
+  return buf;
+}
+
+std::string ok() {
+  return "ok version=" + std::to_string(ta_config_version());
+}
+
+std::string bad_value(const char* key, const char* val) {
+  return std::string("error: bad value for ") + key + ": " + val;
+}
+
+// key=value list after "caps"; parsed in full first, then applied as one snapshot
+// that changes only the keys given
+std::string set_caps(char* args) {
+  ta_caps_t c{};
+  unsigned mask = 0;   // bit t: soft[t], bit 3+t: hard[t], bit 6: on_hardcap
+  int node_set[TA_NUMA_MAX_NODES];
+  unsigned long long node_val[TA_NUMA_MAX_NODES];
+  int nodes = 0;
+  char* save = nullptr;
+  for (char* tok = strtok_r(args, " \t", &save); tok; tok = strtok_r(nullptr, " \t", &save)) {
+    char* eq = std::strchr(tok, '=');
+    if (!eq) return std::string("error: expected key=value, got ") + tok;
+    *eq = '\0';
+    const char* key = tok;
+    const char* val = eq + 1;
+    if (std::strcmp(key, "on_hardcap") == 0) {
+      if (std::strcmp(val, "fail") == 0) c.on_hardcap = TA_HARDCAP_FAIL;
+      else if (std::strcmp(val, "route_slow") == 0) c.on_hardcap = TA_HARDCAP_ROUTE_SLOW;
+      else return std::string("error: on_hardcap must be fail or route_slow");
+      mask |= 1u << 6;
+      continue;
+    }
+    if (std::strncmp(key, "node", 4) == 0) {
+      char* end = nullptr;
+      long n = std::strtol(key + 4, &end, 10);
+      if (end == key + 4 || *end || n < 0 || n >= TA_NUMA_MAX_NODES || nodes == TA_NUMA_MAX_NODES) return std::string("error: bad node ") + key;
+      if (!__ta_parse_size_strict(val, &node_val[nodes])) return bad_value(key, val);
+      node_set[nodes++] = (int)n;
+      continue;
+    }
+    char name[16];
+    const char* us = std::strchr(key, '_');
+    if (!us || (size_t)(us - key) >= sizeof(name)) return std::string("error: unknown key ") + key;
+    std::memcpy(name, key, us - key);
+    name[us - key] = '\0';
+    int t = tier_from_name(name);
+    if (t < 0) return std::string("error: unknown key ") + key;
+    const bool soft = std::strcmp(us + 1, "soft") == 0;
+    if (!soft && std::strcmp(us + 1, "hard") != 0) return std::string("error: unknown key ") + key;
+    if (!__ta_parse_size_strict(val, soft ? &c.soft[t] : &c.hard[t])) return bad_value(key, val);
+    mask |= 1u << (soft ? t : 3 + t);
+  }
+  if (__ta_edit_caps(&c, mask, node_set, node_val, nodes) != 0) return "error: rejected";
+  return ok();
+}
+
+std::string tier_cmd(char* args) {
+  char* save = nullptr;
+  char* name = strtok_r(args, " \t", &save);
+  int t = name ? tier_from_name(name) : -1;
+  if (t < 0) return "error: tier must be fast, normal or slow";
+  ta_tier_cfg_t cfg{};
+  ta_get_tier_cfg((ta_tier_t)t, &cfg);
+  bool any = false;
+  for (char* tok = strtok_r(nullptr, " \t", &save); tok; tok = strtok_r(nullptr, " \t", &save)) {
+    char* eq = std::strchr(tok, '=');
+    if (!eq) return std::string("error: expected key=value, got ") + tok;
+    *eq = '\0';
+    const char* val = eq + 1;
+    bool good = false;
+    if (std::strcmp(tok, "bw") == 0) {
+      unsigned long long bw = 0;
+      good = __ta_parse_size_strict(val, &bw);
+      cfg.bandwidth_Bps = (double)bw;
+    } else if (std::strcmp(tok, "lat") == 0) {
+      char* end = nullptr;
+      errno = 0;
+      cfg.base_latency_ns = std::strtol(val, &end, 10);
+      good = end != val && !*end && errno == 0;
+    } else if (std::strcmp(tok, "cap") == 0) {
+      good = __ta_parse_size_strict(val, &cfg.capacity_bytes);
+    } else {
+      return std::string("error: unknown key ") + tok;
+    }
+    if (!good) return bad_value(tok, val);
+    any = true;
+  }
+  if (any) {
+    if (ta_set_tier_cfg((ta_tier_t)t, &cfg) != 0) return "error: bw must be > 0 and lat >= 0";
+    return ok();
+  }
+  char buf[256];
+  std::snprintf(buf, sizeof(buf), "{\"tier\":\"%s\",\"bandwidth_Bps\":%.0f,\"base_latency_ns\":%ld,\"capacity_bytes\":%llu}",
+                kTierNames[t], cfg.bandwidth_Bps, cfg.base_latency_ns, cfg.capacity_bytes);
+  return buf;
+}
+
+std::string handle(char* line) {
+  line[std::strcspn(line, "\r\n")] = '\0';
+  char* args = line + std::strcspn(line, " \t");
+  if (*args) *args++ = '\0';
+  if (std::strcmp(line, "stats") == 0) {
+    int need = ta_stats_json(nullptr, 0);
+    std::string json(need > 0 ? (size_t)need : 0, '\0');
+    if (need > 0) ta_stats_json(json.data(), (unsigned long long)need + 1);
+    return json;
+  }
+  if (std::strcmp(line, "caps") == 0) return *args ? set_caps(args) : caps_json();
+  if (std::strcmp(line, "tier") == 0) return tier_cmd(args);
+  return std::string("error: unknown command ") + line;
+}
+
+void serve_one(int c) {
+  char line[1024];
+  size_t n = 0;
+  while (n < sizeof(line) - 1) {
+    ssize_t r = read(c, line + n, sizeof(line) - 1 - n);
+    if (r <= 0) break;
+    n += (size_t)r;
+    if (std::memchr(line, '\n', n)) break;
+  }
+  if (n == 0) return;   // closed or timed out without a request
+  line[n] = '\0';
+  std::string reply = handle(line);
+  reply.push_back('\n');
+  for (size_t off = 0; off < reply.size();) {
+    // A client that already hung up must not SIGPIPE the host process
+    ssize_t w = send(c, reply.data() + off, reply.size() - off, MSG_NOSIGNAL);
+    if (w <= 0) break;
+    off += (size_t)w;
+  }
+}
+
+void run(int fd) {
+  while (!L().stop.load(std::memory_order_relaxed)) {
+    int c = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (c < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    // A client that stalls must not hold the only control thread (or exit's join)
+    timeval tv{2, 0};
+    setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(c, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    serve_one(c);
+    close(c);
+  }
+}
+
+void shutdown_listener() {
+  auto& l = L();
+  l.stop.store(true, std::memory_order_relaxed);
+  if (l.fd >= 0) shutdown(l.fd, SHUT_RDWR);   // wakes accept
+  if (l.thr && l.thr->joinable()) l.thr->join();
+  if (l.fd < 0) return;
+  close(l.fd);
+  // Only remove the socket this process bound, not whatever replaced it since
+  struct stat st{};
+  if (getpid() == l.owner && lstat(l.path, &st) == 0 && S_ISSOCK(st.st_mode) &&
+      st.st_dev == l.dev && st.st_ino == l.ino)
+    unlink(l.path);
+}
+
+// The listener thread stayed in the parent. The child drops its copy of the socket:
+// shutdown() at its exit would stop the parent's listener too.
+void on_fork_child() {
+  auto& l = L();
+  l.thr = nullptr;
+  if (l.fd >= 0) close(l.fd);
+  l.fd = -1;
+}
+
+// An existing path is only replaced if it is a socket nobody accepts on any more
+bool clear_stale(const char* path, const sockaddr_un& addr) {
+  struct stat st{};
+  if (lstat(path, &st) != 0) return errno == ENOENT;
+  if (!S_ISSOCK(st.st_mode)) return false;
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe < 0) return false;
+  bool live = connect(probe, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0;
+  close(probe);
+  return !live && unlink(path) == 0;
+}
+
+} // namespace
+
+extern "C" int ta_ctl_listen(const char* path) {
+  auto& l = L();
+  if (!path || !*path || std::strlen(path) >= sizeof(l.path)) return -1;
+  std::scoped_lock lk(l.mtx);
+  if (l.fd >= 0) return -2;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -3;
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::strcpy(addr.sun_path, path);
+  if (!clear_stale(path, addr)) { close(fd); return -4; }
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) { close(fd); return -3; }
+  // Owner-only before anyone can connect; the umask is process-wide, so it stays alone
+  struct stat st{};
+  if (chmod(path, 0600) != 0 || listen(fd, 8) != 0 || lstat(path, &st) != 0) {
+    unlink(path);
+    close(fd);
+    return -3;
+  }
+
+  l.fd = fd;
+  std::strcpy(l.path, path);
+  l.owner = getpid();
+  l.dev = st.st_dev;
+  l.ino = st.st_ino;
+  l.thr = new std::thread(run, fd);   // never freed: joined at exit
+  std::atexit(shutdown_listener);
+  pthread_atfork(nullptr, nullptr, on_fork_child);
+  return 0;
+}
+
+// TA_CTL_SOCKET=<path> starts the listener at init
+extern "C" int __ta_ctl_init(void) {
+  const char* p = std::getenv("TA_CTL_SOCKET");
+  if (!p || !*p) return 1;
+  return ta_ctl_listen(p);
+}
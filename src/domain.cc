@@ -0,0 +1,170 @@
+// Accounting domains: per-tenant tier budgets and counters inside one process.
+// Domain 0 is the default domain (no caps of its own); each thread charges the
+// domain it last selected with ta_domain_set_current.
+#include "tieralloc.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+struct Domain {
+  std::atomic<bool> live{false};
+  char name[32]{};
+  std::atomic<unsigned long long> soft[3]{};
+  std::atomic<unsigned long long> hard[3]{};
+  std::atomic<int> on_hardcap{TA_DOMAIN_ROUTE};
+  std::atomic<unsigned long long> alloc_calls[3]{};
+  std::atomic<unsigned long long> free_calls[3]{};
+  std::atomic<unsigned long long> bytes_current[3]{};
+  std::atomic<unsigned long long> bytes_total_alloc[3]{};
+  std::atomic<unsigned long long> bytes_total_freed[3]{};
+  std::atomic<unsigned long long> simulated_wait_ns[3]{};
+};
+
+Domain g_domains[TA_MAX_DOMAINS];
+std::mutex g_domains_mtx;
+thread_local int t_current = 0;
+
+// Slot 0 is always live, even before static init (interposed malloc can run first)
+inline Domain* get(int d) {
+  if (d == 0) return &g_domains[0];
+  if (d < 0 || d >= TA_MAX_DOMAINS || !g_domains[d].live.load(std::memory_order_acquire)) return nullptr;
+  return &g_domains[d];
+}
+
+// A destroyed domain can still be charged by allocations that read its id just
+// before it went; its slot is only reused once those are freed again
+bool holds_memory(const Domain& dm) {
+  for (int t = 0; t < 3; ++t)
+    if (dm.bytes_current[t].load(std::memory_order_acquire) != 0) return true;
+  return false;
+}
+
+void set_caps(Domain& dm, const ta_domain_caps_t* caps) {
+  for (int t = 0; t < 3; ++t) {
+    dm.soft[t].store(caps ? caps->soft[t] : 0, std::memory_order_relaxed);
+    dm.hard[t].store(caps ? caps->hard[t] : 0, std::memory_order_relaxed);
+  }
+  dm.on_hardcap.store(caps ? caps->on_hardcap : TA_DOMAIN_ROUTE, std::memory_order_relaxed);
+}
+
+} // namespace
+
+extern "C" ta_domain_t ta_domain_create(const char* name, const ta_domain_caps_t* caps) {
+  std::scoped_lock lk(g_domains_mtx);
+  for (int d = 1; d < TA_MAX_DOMAINS; ++d) {
+    Domain& dm = g_domains[d];
+    if (dm.live.load(std::memory_order_relaxed) || holds_memory(dm)) continue;
+    std::memset(dm.name, 0, sizeof(dm.name));
+    if (name) std::strncpy(dm.name, name, sizeof(dm.name) - 1);
+    set_caps(dm, caps);
+    for (int t = 0; t < 3; ++t) {
+      dm.alloc_calls[t] = 0; dm.free_calls[t] = 0; dm.bytes_current[t] = 0;
+      dm.bytes_total_alloc[t] = 0; dm.bytes_total_freed[t] = 0; dm.simulated_wait_ns[t] = 0;
+    }
+    dm.live.store(true, std::memory_order_release);
+    return d;
+  }
+  return -1;
+}
+
+// Only empty domains can go. Threads that still have it selected fall back to the
+// default domain; the id may be reused afterwards.
+extern "C" int ta_domain_destroy(ta_domain_t d) {
+  if (d == 0) return -1;
+  std::scoped_lock lk(g_domains_mtx);
+  Domain* dm = get(d);
+  if (!dm) return -1;
+  if (holds_memory(*dm)) return -2;
+  dm->live.store(false, std::memory_order_release);
+  if (t_current == d) t_current = 0;
+  return 0;
+}
+
+extern "C" int ta_domain_set_caps(ta_domain_t d, const ta_domain_caps_t* caps) {
+  Domain* dm = get(d);
+  if (!dm) return -1;
+  set_caps(*dm, caps);
+  return 0;
+}
+
+extern "C" ta_domain_t ta_domain_set_current(ta_domain_t d) {
+  int prev = t_current;
+  t_current = get(d) ? d : 0;
+  return prev;
+}
+
+extern "C" ta_domain_t ta_domain_current(void) {
+  // Another thread may have destroyed it since this one selected it
+  if (t_current != 0 && !get(t_current)) t_current = 0;
+  return t_current;
+}
+
+extern "C" int ta_domain_get_stats(ta_domain_t d, ta_stats_snapshot_t* out) {
+  Domain* dm = get(d);
+  if (!dm || !out) return -1;
+  for (int t = 0; t < 3; ++t) {
+    out->alloc_calls[t]       = dm->alloc_calls[t].load(std::memory_order_relaxed);
+    out->free_calls[t]        = dm->free_calls[t].load(std::memory_order_relaxed);
+    out->bytes_current[t]     = dm->bytes_current[t].load(std::memory_order_relaxed);
+    out->bytes_total_alloc[t] = dm->bytes_total_alloc[t].load(std::memory_order_relaxed);
+    out->bytes_total_freed[t] = dm->bytes_total_freed[t].load(std::memory_order_relaxed);
+    out->simulated_wait_ns[t] = dm->simulated_wait_ns[t].load(std::memory_order_relaxed);
+  }
+  return 0;
+}
+
+extern "C" const char* ta_domain_name(ta_domain_t d) {
+  if (d == 0) return "default";
+  Domain* dm = get(d);
+  return dm ? dm->name : nullptr;
+}
+
+// --- Internal helpers used by policy/allocator ---
+
+// Whether `bytes` more in tier t keeps domain d under its soft (or only hard) cap
+extern "C" bool __ta_domain_fits(int d, int t, unsigned long long bytes, bool hard_only) {
+  Domain* dm = get(d);
+  if (!dm) return true;
+  unsigned long long cur = dm->bytes_current[t].load(std::memory_order_relaxed);
+  unsigned long long hard = dm->hard[t].load(std::memory_order_relaxed);
+  if (hard && cur + bytes > hard) return false;
+  if (hard_only) return true;
+  unsigned long long soft = dm->soft[t].load(std::memory_order_relaxed);
+  return !soft || cur + bytes <= soft;
+}
+
+// Bytes domain d must give up in tier t before `bytes` more fit under its hard cap;
+// 0 if they fit or the domain routes instead of demoting
+extern "C" unsigned long long __ta_domain_demote_need(int d, int t, unsigned long long bytes) {
+  Domain* dm = get(d);
+  if (!dm || dm->on_hardcap.load(std::memory_order_relaxed) != TA_DOMAIN_DEMOTE) return 0;
+  unsigned long long hard = dm->hard[t].load(std::memory_order_relaxed);
+  unsigned long long cur = dm->bytes_current[t].load(std::memory_order_relaxed);
+  if (!hard || cur + bytes <= hard || bytes > hard) return 0;
+  return cur + bytes - hard;
+}
+
+extern "C" void __ta_domain_add_alloc(int d, ta_tier_t t, unsigned long long calls, unsigned long long sz, long wait_ns) {
+  Domain& dm = g_domains[(d >= 0 && d < TA_MAX_DOMAINS) ? d : 0];
+  dm.alloc_calls[(int)t] += calls;
+  dm.bytes_current[(int)t] += sz;
+  dm.bytes_total_alloc[(int)t] += sz;
+  if (wait_ns > 0) dm.simulated_wait_ns[(int)t] += (unsigned long long)wait_ns;
+}
+
+extern "C" void __ta_domain_add_free(int d, ta_tier_t t, unsigned long long calls, unsigned long long sz) {
+  Domain& dm = g_domains[(d >= 0 && d < TA_MAX_DOMAINS) ? d : 0];
+  dm.free_calls[(int)t] += calls;
+  dm.bytes_current[(int)t] -= sz;
+  dm.bytes_total_freed[(int)t] += sz;
+}
+
+extern "C" void __ta_domain_move(int d, ta_tier_t from, ta_tier_t to, unsigned long long sz) {
+  Domain& dm = g_domains[(d >= 0 && d < TA_MAX_DOMAINS) ? d : 0];
+  // Add before taking away, so the domain never reads as empty mid-move
+  dm.bytes_current[(int)to] += sz;
+  dm.bytes_current[(int)from] -= sz;
+}
@@ -28,6 +28,12 @@ static void* (*real_realloc)(void*,size_t) = NULL;
 
 extern "C" int __ta_internal_get_size(const void* p, unsigned long long* out_size);
 
+// tieralloc's own bookkeeping holds this while it may allocate under a lock: those
+// allocations go straight to libc instead of back into ta_alloc/ta_free
+extern "C" void __ta_hook_bypass(int delta) {
+    g_in_hook += delta;
+}
+
 static void resolve_libc(void) {
     if (!real_malloc) real_malloc = (void*(*)(size_t)) dlsym(RTLD_NEXT, "malloc");
     if (!real_free)   real_free   = (void (*)(void*)) dlsym(RTLD_NEXT, "free");
@@ -75,14 +81,18 @@ extern "C" void* realloc(void* p, size_t n) {
   ta_tier_t t;
   if (ta_tier_of(p, &t) == 0) {
     void* q = ta_alloc(n, TA_HINT_DEFAULT);
-    if (!p) return NULL;
+    if (!q) return NULL;
 
     unsigned long long old_sz = 0;
     size_t copy_n = 0;
     if (__ta_internal_get_size(p, &old_sz) == 0) {
       copy_n = (size_t)((old_sz < (unsigned long long)n) ? old_sz : (unsigned long long)n);
     }
-    if (copy_n > 0) memcpy(q, p, copy_n);
+    ta_tier_t qt;
+    if (copy_n > 0) {
+      if (ta_tier_of(q, &qt) == 0) ta_copy(q, p, copy_n, qt);
+      else memcpy(q, p, copy_n);
+    }
 
     ta_free(p);
     return q;
@@ -0,0 +1,334 @@
+// Paged KV-cache block manager: one arena of fixed-size blocks, per-tier residency
+// limits, refcounted block tables per sequence, and recency-driven tier moves done
+// with in-place page migration (block addresses never change).
+#include "tieralloc.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+extern "C" void __ta_add_alloc(ta_tier_t, unsigned long long, long);
+extern "C" void __ta_add_free(ta_tier_t, unsigned long long);
+extern "C" void __ta_move_tier(ta_tier_t, ta_tier_t, unsigned long long, long);
+struct ta_placement;
+extern "C" const ta_placement* __ta_tier_placement(ta_tier_t tier);
+extern "C" int __ta_placement_home(const ta_placement* pl);
+extern "C" int __ta_place_range(void* p, unsigned long long len, const ta_placement* pl);
+extern "C" void __ta_place_account(const ta_placement* pl, const void* p, unsigned long long len,
+                                   unsigned long long page, int sign);
+extern "C" int __ta_migrate_range(void* p, unsigned long long len, const ta_placement* to, bool exclusive);
+extern "C" void __ta_copy(void* dst, const void* src, unsigned long long n, int dst_node);
+
+namespace {
+
+struct Block {
+    int tier{-1};                       // -1: on the free list
+    int refs{0};
+    uint64_t stamp{0};                  // most recent use by any owner
+    const ta_placement* pl{nullptr};
+};
+
+struct Seq {
+    std::vector<int> blocks;
+    uint64_t stamp{0};
+};
+
+} // namespace
+
+struct ta_kv {
+    std::mutex mtx;
+    char* base{nullptr};
+    unsigned long long block_bytes{0};
+    unsigned cap[3]{};
+    unsigned used[3]{};
+    std::vector<Block> blocks;
+    std::vector<int> free_list[3];              // free blocks by the tier whose policy covers them
+    std::unordered_map<long long, Seq> seqs;
+    std::set<std::pair<uint64_t, int>> lru[3];   // (stamp, block) per tier, oldest first
+    uint64_t clock{0};
+    unsigned long long promotions{0}, demotions{0}, cow_copies{0};
+};
+
+namespace {
+
+inline char* block_ptr(ta_kv* kv, int b) {
+    return kv->base + (unsigned long long)b * kv->block_bytes;
+}
+
+size_t free_blocks(const ta_kv* kv) {
+    return kv->free_list[0].size() + kv->free_list[1].size() + kv->free_list[2].size();
+}
+
+void set_stamp(ta_kv* kv, int b, uint64_t stamp) {
+    Block& blk = kv->blocks[b];
+    if (stamp <= blk.stamp) return;
+    kv->lru[blk.tier].erase({blk.stamp, b});
+    blk.stamp = stamp;
+    kv->lru[blk.tier].insert({stamp, b});
+}
+
+// Migrate one block's pages to another tier and move its accounting along
+bool move_block(ta_kv* kv, int b, int to) {
+    Block& blk = kv->blocks[b];
+    const int from = blk.tier;
+    const ta_placement* pl = __ta_tier_placement((ta_tier_t)to);
+    // Views may be written concurrently: kernel moves only, never the copy fallback
+    if (__ta_migrate_range(block_ptr(kv, b), kv->block_bytes, pl, false) < 0) return false;
+
+    ta_charge_info_t info{0};
+    (void) ta_charge_bytes((ta_tier_t)from, kv->block_bytes, &info);
+    (void) ta_charge_bytes((ta_tier_t)to, kv->block_bytes, &info);
+    __ta_move_tier((ta_tier_t)from, (ta_tier_t)to, kv->block_bytes, info.simulated_wait_ns);
+    __ta_place_account(blk.pl, block_ptr(kv, b), kv->block_bytes, 0, -1);
+    __ta_place_account(pl, block_ptr(kv, b), kv->block_bytes, 0, +1);
+
+    kv->lru[from].erase({blk.stamp, b});
+    kv->used[from]--;
+    blk.tier = to;
+    blk.pl = pl;
+    kv->lru[to].insert({blk.stamp, b});
+    kv->used[to]++;
+    if (to < from) kv->promotions++; else kv->demotions++;
+    return true;
+}
+
+// Free a slot in tier t for something used at `stamp`: each full tier's least
+// recently used block moves one tier down, but only if it is older than the block
+// taking its place. Finds the first tier with room, then shifts from the bottom up.
+bool make_room(ta_kv* kv, int t, uint64_t stamp) {
+    int last = t;
+    for (uint64_t s = stamp; kv->used[last] >= kv->cap[last]; ++last) {
+        if (last >= 2 || kv->lru[last].empty()) return false;
+        uint64_t vstamp = kv->lru[last].begin()->first;
+        if (vstamp >= s) return false;
+        s = vstamp;
+    }
+    for (int k = last - 1; k >= t; --k)
+        if (!move_block(kv, kv->lru[k].begin()->second, k + 1)) return false;
+    return true;
+}
+
+int alloc_block(ta_kv* kv, uint64_t stamp) {
+    if (free_blocks(kv) == 0) return -1;
+    int t = 0;
+    while (t < 3 && !make_room(kv, t, stamp)) ++t;
+    if (t == 3) return -1;
+    // Prefer a block whose range already has tier t's policy; rebinding another one
+    // splits its VMA off the region
+    int src = t;
+    for (int i = 0; i < 3 && kv->free_list[src].empty(); ++i) src = i;
+    int b = kv->free_list[src].back();
+    const ta_placement* pl = __ta_tier_placement((ta_tier_t)t);
+    // Pages were dropped on release, so the policy applies at first touch
+    if (src != t && __ta_place_range(block_ptr(kv, b), kv->block_bytes, pl) < 0) return -1;
+    kv->free_list[src].pop_back();
+    Block& blk = kv->blocks[b];
+    blk.pl = pl;
+    blk.tier = t;
+    blk.refs = 1;
+    blk.stamp = stamp;
+    kv->lru[t].insert({stamp, b});
+    kv->used[t]++;
+    __ta_add_alloc((ta_tier_t)t, kv->block_bytes, 0);
+    __ta_place_account(blk.pl, block_ptr(kv, b), kv->block_bytes, 0, +1);
+    return b;
+}
+
+void release_block(ta_kv* kv, int b) {
+    Block& blk = kv->blocks[b];
+    if (--blk.refs > 0) return;
+    kv->lru[blk.tier].erase({blk.stamp, b});
+    kv->used[blk.tier]--;
+    __ta_add_free((ta_tier_t)blk.tier, kv->block_bytes);
+    __ta_place_account(blk.pl, block_ptr(kv, b), kv->block_bytes, 0, -1);
+    madvise(block_ptr(kv, b), kv->block_bytes, MADV_DONTNEED);
+    // Its range keeps the policy of the tier it was last placed in
+    kv->free_list[blk.tier].push_back(b);
+    blk = Block{};
+}
+
+// Mark a sequence as just used and pull its blocks toward FAST
+void touch_seq(ta_kv* kv, Seq& s) {
+    s.stamp = ++kv->clock;
+    for (int b : s.blocks) set_stamp(kv, b, s.stamp);
+    for (int b : s.blocks) {
+        for (int t = 0; t < kv->blocks[b].tier; ++t) {
+            if (make_room(kv, t, s.stamp)) {
+                if (move_block(kv, b, t)) break;
+                continue;
+            }
+            // Tier t is full of older blocks and nothing below has room: trade places
+            // with its least recently used block
+            if (kv->lru[t].empty()) continue;
+            auto [vstamp, victim] = *kv->lru[t].begin();
+            if (vstamp >= s.stamp) continue;
+            if (!move_block(kv, victim, kv->blocks[b].tier)) continue;
+            if (move_block(kv, b, t)) break;
+            // Put the victim back rather than leave its new tier over cap
+            (void) move_block(kv, victim, t);
+        }
+    }
+}
+
+} // namespace
+
+extern "C" ta_kv_t* ta_kv_create(const ta_kv_cfg_t* cfg) {
+    if (!cfg || cfg->block_bytes == 0) return nullptr;
+    const unsigned long long page = (unsigned long long) sysconf(_SC_PAGESIZE);
+    unsigned long long total_blocks = 0;
+    for (int t = 0; t < 3; ++t) total_blocks += cfg->blocks[t];
+    if (total_blocks == 0 || total_blocks > (1ull << 31)) return nullptr;
+
+    auto* kv = new (std::nothrow) ta_kv;
+    if (!kv) return nullptr;
+    kv->block_bytes = (cfg->block_bytes + page - 1) / page * page;
+    void* p = mmap(nullptr, total_blocks * kv->block_bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) { delete kv; return nullptr; }
+    kv->base = static_cast<char*>(p);
+    for (int t = 0; t < 3; ++t) kv->cap[t] = cfg->blocks[t];
+    kv->blocks.resize(total_blocks);
+    // One region per tier, placed once up front: blocks [first, first + cap) start
+    // out under that tier's policy
+    unsigned long long first = 0;
+    for (int t = 0; t < 3; ++t) {
+        const unsigned long long n = cfg->blocks[t];
+        if (n && __ta_place_range(block_ptr(kv, (int)first), n * kv->block_bytes,
+                                  __ta_tier_placement((ta_tier_t)t)) < 0) {
+            munmap(kv->base, total_blocks * kv->block_bytes);
+            delete kv;
+            return nullptr;
+        }
+        kv->free_list[t].reserve(n);
+        // Hand out low block ids first
+        for (unsigned long long i = n; i-- > 0;) kv->free_list[t].push_back((int)(first + i));
+        first += n;
+    }
+    return kv;
+}
+
+extern "C" void ta_kv_destroy(ta_kv_t* kv) {
+    if (!kv) return;
+    for (size_t b = 0; b < kv->blocks.size(); ++b) {
+        const Block& blk = kv->blocks[b];
+        if (blk.tier < 0) continue;
+        __ta_add_free((ta_tier_t)blk.tier, kv->block_bytes);
+        __ta_place_account(blk.pl, block_ptr(kv, (int)b), kv->block_bytes, 0, -1);
+    }
+    munmap(kv->base, kv->blocks.size() * kv->block_bytes);
+    delete kv;
+}
+
+extern "C" unsigned long long ta_kv_block_bytes(const ta_kv_t* kv) {
+    return kv ? kv->block_bytes : 0;
+}
+
+extern "C" void* ta_kv_block_ptr(ta_kv_t* kv, int block) {
+    if (!kv || block < 0 || (size_t)block >= kv->blocks.size()) return nullptr;
+    return block_ptr(kv, block);
+}
+
+extern "C" int ta_kv_block_tier(ta_kv_t* kv, int block) {
+    if (!kv || block < 0 || (size_t)block >= kv->blocks.size()) return -1;
+    std::scoped_lock lk(kv->mtx);
+    return kv->blocks[block].tier;
+}
+
+extern "C" int ta_kv_seq_append(ta_kv_t* kv, long long seq, unsigned nblocks) {
+    if (!kv) return -1;
+    std::scoped_lock lk(kv->mtx);
+    if (free_blocks(kv) < nblocks) return -2;
+    Seq& s = kv->seqs[seq];
+    touch_seq(kv, s);
+    const size_t before = s.blocks.size();
+    for (unsigned i = 0; i < nblocks; ++i) {
+        int b = alloc_block(kv, s.stamp);
+        if (b < 0) {
+            // All or nothing
+            while (s.blocks.size() > before) { release_block(kv, s.blocks.back()); s.blocks.pop_back(); }
+            if (s.blocks.empty()) kv->seqs.erase(seq);
+            return -2;
+        }
+        s.blocks.push_back(b);
+    }
+    return (int)s.blocks.size();
+}
+
+extern "C" int ta_kv_seq_fork(ta_kv_t* kv, long long parent, long long child) {
+    if (!kv) return -1;
+    std::scoped_lock lk(kv->mtx);
+    auto it = kv->seqs.find(parent);
+    if (it == kv->seqs.end() || kv->seqs.count(child)) return -2;
+    Seq copy = it->second;
+    for (int b : copy.blocks) kv->blocks[b].refs++;
+    kv->seqs.emplace(child, std::move(copy));
+    return 0;
+}
+
+extern "C" int ta_kv_seq_free(ta_kv_t* kv, long long seq) {
+    if (!kv) return -1;
+    std::scoped_lock lk(kv->mtx);
+    auto it = kv->seqs.find(seq);
+    if (it == kv->seqs.end()) return -2;
+    for (int b : it->second.blocks) release_block(kv, b);
+    kv->seqs.erase(it);
+    return 0;
+}
+
+extern "C" int ta_kv_seq_blocks(ta_kv_t* kv, long long seq, int* out, unsigned max) {
+    if (!kv) return -1;
+    std::scoped_lock lk(kv->mtx);
+    auto it = kv->seqs.find(seq);
+    if (it == kv->seqs.end()) return -2;
+    const auto& v = it->second.blocks;
+    for (size_t i = 0; out && i < v.size() && i < max; ++i) out[i] = v[i];
+    return (int)v.size();
+}
+
+// Give seq a private copy of table entry idx before it writes into a shared block
+extern "C" int ta_kv_seq_writable(ta_kv_t* kv, long long seq, unsigned idx) {
+    if (!kv) return -1;
+    std::scoped_lock lk(kv->mtx);
+    auto it = kv->seqs.find(seq);
+    if (it == kv->seqs.end() || idx >= it->second.blocks.size()) return -2;
+    Seq& s = it->second;
+    int old = s.blocks[idx];
+    if (kv->blocks[old].refs == 1) return old;
+    s.stamp = ++kv->clock;
+    int b = alloc_block(kv, s.stamp);
+    if (b < 0) return -3;
+    __ta_copy(block_ptr(kv, b), block_ptr(kv, old), kv->block_bytes, __ta_placement_home(kv->blocks[b].pl));
+    release_block(kv, old);
+    s.blocks[idx] = b;
+    kv->cow_copies++;
+    return b;
+}
+
+extern "C" int ta_kv_touch(ta_kv_t* kv, long long seq) {
+    if (!kv) return -1;
+    std::scoped_lock lk(kv->mtx);
+    auto it = kv->seqs.find(seq);
+    if (it == kv->seqs.end()) return -2;
+    touch_seq(kv, it->second);
+    return 0;
+}
+
+extern "C" void ta_kv_get_stats(ta_kv_t* kv, ta_kv_stats_t* out) {
+    if (!kv || !out) return;
+    std::scoped_lock lk(kv->mtx);
+    for (int t = 0; t < 3; ++t) {
+        out->blocks_used[t] = kv->used[t];
+        out->blocks_cap[t] = kv->cap[t];
+    }
+    out->blocks_free = (unsigned) free_blocks(kv);
+    out->sequences = (unsigned) kv->seqs.size();
+    out->promotions = kv->promotions;
+    out->demotions = kv->demotions;
+    out->cow_copies = kv->cow_copies;
+}
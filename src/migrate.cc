@@ -1 +1,58 @@
 // move_pages wrapper + memcpy fallback
+// In-place migration of a mapped range to another placement: the kernel moves the pages
+// (mbind + MPOL_MF_MOVE); if it refuses, the data is copied into a freshly placed
+// mapping that is then mremap()'d over the original address, so callers keep their pointer.
+// That copy does not see writes made while it runs, and the range must not be unmapped
+// meanwhile: only callers that exclude both (exclusive=true) get the fallback.
+#include "tieralloc.h"
+
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct ta_placement;
+extern "C" bool __ta_place_enabled(void);
+extern "C" int __ta_place_range(void* p, unsigned long long len, const ta_placement* pl);
+extern "C" int __ta_place_range_ex(void* p, unsigned long long len, const ta_placement* pl, bool move);
+extern "C" int __ta_placement_home(const ta_placement* pl);
+extern "C" unsigned long long __ta_placement_cycle(const ta_placement* pl, unsigned long long page);
+extern "C" void __ta_copy(void* dst, const void* src, unsigned long long n, int dst_node);
+extern "C" void __ta_add_migration(unsigned long long attempted, unsigned long long moved_pages, unsigned long long failed_pages);
+
+// Returns 0 when pages were moved, 1 when placement is simulated (nothing to move), <0 on failure
+extern "C" int __ta_migrate_range(void* p, unsigned long long len, const ta_placement* to, bool exclusive) {
+  if (!p || len == 0 || !to) return -1;
+  if (!__ta_place_enabled()) return 1;
+  const unsigned long long pages = len / (unsigned long long)sysconf(_SC_PAGESIZE);
+
+  if (__ta_place_range_ex(p, len, to, true) == 0) {
+    __ta_add_migration(1, pages, 0);
+    return 0;
+  }
+
+  if (!exclusive) { __ta_add_migration(1, 0, pages); return -4; }
+
+  // Fallback: copy into a new mapping with the target policy, then swap it in place.
+  // mremap keeps the pages where the copy faulted them, by q's interleave index, so q
+  // sits at p's offset within an interleave cycle (of 2M pages if p could hold them)
+  const unsigned long long page = ((uintptr_t)p % (2ull << 20)) ? (unsigned long long)sysconf(_SC_PAGESIZE) : (2ull << 20);
+  const unsigned long long cycle = __ta_placement_cycle(to, page);
+  void* raw = mmap(nullptr, len + cycle, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) { __ta_add_migration(1, 0, pages); return -2; }
+  uintptr_t base = (uintptr_t)raw, at = base;
+  if (cycle) {
+    at += ((uintptr_t)p % cycle + cycle - base % cycle) % cycle;
+    if (at > base) munmap(raw, at - base);
+    if (base + cycle > at) munmap((void*)(at + len), base + cycle - at);
+  }
+  void* q = (void*)at;
+  __ta_place_range(q, len, to);
+  __ta_copy(q, p, len, __ta_placement_home(to));
+  if (mremap(q, len, len, MREMAP_MAYMOVE | MREMAP_FIXED, p) == MAP_FAILED) {
+    munmap(q, len);
+    __ta_add_migration(1, 0, pages);
+    return -3;
+  }
+  __ta_add_migration(1, pages, 0);
+  return 0;
+}
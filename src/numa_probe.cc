@@ -2,13 +2,21 @@
 #include "numa_probe.h"
 #include "tieralloc.h"
 
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
 
+#if defined(TA_HAVE_LIBNUMA)
+#include <numa.h>
+#endif
+
 extern "C" void __ta_set_backend(const char* name);
 extern "C" void __ta_set_node_mapping(int fast, int normal, int slow);
 extern "C" void __ta_set_node_count(int count);
+extern "C" void __ta_set_tier_nodes(int tier, const int* nodes, int n);
+extern "C" void __ta_place_rebuild(void);
+extern "C" int __ta_config_node(int node, double* bw_Bps, long* lat_ns);
 
 static ta_numa_info& state() {
   static ta_numa_info s;
@@ -20,12 +28,197 @@ static inline int getenv_int(const char* k, int defv) {
   return defv;
 }
 
+// Parse a sysfs cpulist ("0-3,8,10-11") into a cpu_set_t
+static bool parse_cpulist(const char* s, cpu_set_t* out) {
+  CPU_ZERO(out);
+  bool any = false;
+  while (s && *s) {
+    char* end = nullptr;
+    long a = std::strtol(s, &end, 10);
+    if (end == s) break;
+    long b = a;
+    if (*end == '-') { s = end + 1; b = std::strtol(s, &end, 10); }
+    for (long c = a; c <= b && c < CPU_SETSIZE; ++c) { CPU_SET((int)c, out); any = true; }
+    s = (*end == ',') ? end + 1 : nullptr;
+  }
+  return any;
+}
+
+// Parse "1,3" / "0-2" into at most cap ints; returns count
+static int parse_int_list(const char* s, int* out, int cap) {
+  int n = 0;
+  while (s && *s && n < cap) {
+    char* end = nullptr;
+    long a = std::strtol(s, &end, 10);
+    if (end == s) break;
+    long b = a;
+    if (*end == '-') { s = end + 1; b = std::strtol(s, &end, 10); }
+    for (long v = a; v <= b && n < cap; ++v) out[n++] = (int)v;
+    s = (*end == ',') ? end + 1 : nullptr;
+  }
+  return n;
+}
+
+static bool read_line(const char* path, char* buf, size_t n) {
+  FILE* f = std::fopen(path, "r");
+  if (!f) return false;
+  bool ok = std::fgets(buf, (int)n, f) != nullptr;
+  std::fclose(f);
+  return ok;
+}
+
+// CPUs, distances and capacity per node from sysfs; calibrated figures from the config file
+static void load_topology(ta_numa_info& s) {
+  for (int n = 0; n < s.node_count && n < TA_NUMA_MAX_NODES; ++n) {
+    char path[96];
+    char line[4096];
+    CPU_ZERO(&s.node_cpus[n]);
+    std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+    if (read_line(path, line, sizeof(line))) parse_cpulist(line, &s.node_cpus[n]);
+
+    std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/distance", n);
+    if (read_line(path, line, sizeof(line))) {
+      char* p = line;
+      for (int m = 0; m < s.node_count && m < TA_NUMA_MAX_NODES; ++m) {
+        char* end = nullptr;
+        long d = std::strtol(p, &end, 10);
+        if (end == p) break;
+        s.distance[n][m] = (int)d;
+        p = end;
+      }
+    }
+
+    s.node_mem_bytes[n] = 0;
+    std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", n);
+    if (FILE* f = std::fopen(path, "r")) {
+      while (std::fgets(line, sizeof(line), f)) {
+        unsigned long long kb = 0;
+        if (std::sscanf(line, "Node %*d MemTotal: %llu kB", &kb) == 1) { s.node_mem_bytes[n] = kb << 10; break; }
+      }
+      std::fclose(f);
+    }
+
+    double bw = 0.0;
+    long lat = 0;
+    if (__ta_config_node(n, &bw, &lat) == 0) { s.node_bw_Bps[n] = bw; s.node_lat_ns[n] = lat; }
+  }
+  // Without sysfs, assume the one node we know about has memory and is local
+  if (s.node_count == 1 && s.node_mem_bytes[0] == 0) s.node_mem_bytes[0] = 1;
+  if (s.distance[0][0] == 0) s.distance[0][0] = 10;
+}
+
+static int g_cpu_node[CPU_SETSIZE];
+
+// cpu -> node table and per-node nearest CPU nodes, for locality-aware placement
+static void build_locality(ta_numa_info& s) {
+  std::fill(g_cpu_node, g_cpu_node + CPU_SETSIZE, -1);
+  const int lim = std::min(s.node_count, TA_NUMA_MAX_NODES);
+  for (int n = 0; n < lim; ++n)
+    for (int c = 0; c < CPU_SETSIZE; ++c)
+      if (CPU_ISSET(c, &s.node_cpus[n])) g_cpu_node[c] = n;
+  for (int n = 0; n < lim; ++n) {
+    int k = 0;
+    for (int m = 0; m < lim; ++m)
+      if (s.node_mem_bytes[m] && CPU_COUNT(&s.node_cpus[m]) > 0) s.nearest[n][k++] = m;
+    std::stable_sort(s.nearest[n], s.nearest[n] + k, [&](int a, int b) {
+      int da = (a == n) ? 0 : (s.distance[n][a] ? s.distance[n][a] : 255);
+      int db = (b == n) ? 0 : (s.distance[n][b] ? s.distance[n][b] : 255);
+      return da < db;
+    });
+    s.nearest_count[n] = k;
+  }
+}
+
+static void set_tier(ta_numa_info& s, int t, const int* nodes, int n) {
+  n = std::clamp(n, 1, TA_NUMA_MAX_NODES);
+  for (int i = 0; i < n; ++i) { s.tier_nodes[t][i] = nodes[i]; s.tier_weights[t][i] = 1; }
+  s.tier_nnodes[t] = n;
+  s.tier_node[t] = nodes[0];
+}
+
+// Tier map from topology, seen from the first node with CPUs:
+//   FAST   = CPU nodes at local distance (covers sub-NUMA clusters on one socket)
+//   NORMAL = remaining CPU nodes (other sockets)
+//   SLOW   = memory-only nodes (CXL, PMEM)
+// Empty tiers borrow from the next faster one.
+static bool auto_tier_map(ta_numa_info& s) {
+  int ref = -1;
+  int fast[TA_NUMA_MAX_NODES], normal[TA_NUMA_MAX_NODES], slow[TA_NUMA_MAX_NODES];
+  int nf = 0, nn = 0, ns = 0;
+  const int lim = std::min(s.node_count, TA_NUMA_MAX_NODES);
+  for (int n = 0; n < lim && ref < 0; ++n)
+    if (s.node_mem_bytes[n] && CPU_COUNT(&s.node_cpus[n]) > 0) ref = n;
+  if (ref < 0) return false;
+
+  // Same-socket threshold: halfway between local (10) and the farthest CPU node.
+  // Remote sockets sit at 20+ in SLIT tables; if none does, every CPU node is local.
+  int far_cpu = 10;
+  for (int n = 0; n < lim; ++n) {
+    if (n == ref || !s.node_mem_bytes[n] || CPU_COUNT(&s.node_cpus[n]) == 0) continue;
+    far_cpu = std::max(far_cpu, s.distance[ref][n]);
+  }
+  const int local_below = (far_cpu >= 20) ? (10 + far_cpu) / 2 : far_cpu + 1;
+  for (int n = 0; n < lim; ++n) {
+    if (!s.node_mem_bytes[n]) continue;
+    int d = s.distance[ref][n] ? s.distance[ref][n] : 10;
+    bool cpus = CPU_COUNT(&s.node_cpus[n]) > 0;
+    if (!cpus) slow[ns++] = n;
+    else if (n == ref || d < local_below) fast[nf++] = n;
+    else normal[nn++] = n;
+  }
+  set_tier(s, 0, fast, nf);
+  if (nn) set_tier(s, 1, normal, nn); else if (ns) set_tier(s, 1, slow, ns); else set_tier(s, 1, fast, nf);
+  if (ns) set_tier(s, 2, slow, ns); else set_tier(s, 2, s.tier_nodes[1], s.tier_nnodes[1]);
+  return true;
+}
+
+// TA_NODES_<TIER>, TA_WEIGHTS_<TIER>, TA_MODE_<TIER>
+static void load_tier_nodes(ta_numa_info& s, int t, const char* name) {
+  char key[32];
+
+  std::snprintf(key, sizeof(key), "TA_NODES_%s", name);
+  int tmp[TA_NUMA_MAX_NODES];
+  int n = parse_int_list(std::getenv(key), tmp, TA_NUMA_MAX_NODES);
+  int kept = 0;
+  for (int i = 0; i < n; ++i) {
+    if (tmp[i] < 0 || tmp[i] > std::max(0, s.max_node)) continue;
+    if (std::find(tmp, tmp + kept, tmp[i]) != tmp + kept) continue;
+    tmp[kept++] = tmp[i];
+  }
+  if (kept > 0) set_tier(s, t, tmp, kept);
+
+  // Weights: explicit, else proportional to calibrated bandwidth when every node has one
+  std::snprintf(key, sizeof(key), "TA_WEIGHTS_%s", name);
+  int w[TA_NUMA_MAX_NODES];
+  int nw = parse_int_list(std::getenv(key), w, TA_NUMA_MAX_NODES);
+  bool calibrated = s.tier_nnodes[t] > 1;
+  for (int i = 0; i < s.tier_nnodes[t]; ++i) calibrated &= s.node_bw_Bps[s.tier_nodes[t][i]] > 0.0;
+  if (nw > 0) {
+    for (int i = 0; i < nw && i < s.tier_nnodes[t]; ++i) s.tier_weights[t][i] = (unsigned)std::max(0, w[i]);
+  } else if (calibrated) {
+    // 1 weight unit per ~1 GB/s
+    for (int i = 0; i < s.tier_nnodes[t]; ++i)
+      s.tier_weights[t][i] = (unsigned)std::max(1.0, s.node_bw_Bps[s.tier_nodes[t][i]] / 1e9 + 0.5);
+  }
+
+  bool uneven = false;
+  for (int i = 1; i < s.tier_nnodes[t]; ++i) uneven |= (s.tier_weights[t][i] != s.tier_weights[t][0]);
+
+  ta_place_mode m = ta_place_mode::preferred;
+  if (s.tier_nnodes[t] > 1) m = uneven ? ta_place_mode::weighted : ta_place_mode::interleave;
+  std::snprintf(key, sizeof(key), "TA_MODE_%s", name);
+  if (const char* v = std::getenv(key)) {
+    if (std::strcmp(v, "preferred") == 0) m = ta_place_mode::preferred;
+    else if (std::strcmp(v, "interleave") == 0) m = ta_place_mode::interleave;
+    else if (std::strcmp(v, "weighted") == 0) m = ta_place_mode::weighted;
+  }
+  s.tier_mode[t] = m;
+}
+
 void ta_numa_init_from_env() {
   auto& s = state();
 
 #if defined(TA_HAVE_LIBNUMA)
-  #include <numa.h>
-  #include <numaif.h>
   if (numa_available() >= 0) {
     s.available = true;
     s.max_node  = numa_max_node();
@@ -47,19 +240,35 @@ void ta_numa_init_from_env() {
   s.backend = "simulated";
 #endif
 
-  // Default mapping: FAST->0, NORMAL->1 (if exists else 0), SLOW->min(2 or last)
-  int n0 = 0;
-  int n1 = (s.node_count > 1) ? 1 : 0;
-  int n2 = (s.node_count > 2) ? 2 : n1;
+  load_topology(s);
+  build_locality(s);
 
-  s.tier_node[0] = n0;
-  s.tier_node[1] = n1;
-  s.tier_node[2] = n2;
+  // Default mapping: derived from topology (TA_TIER_MAP=auto, the default), or the
+  // static FAST->0, NORMAL->1 (if exists else 0), SLOW->min(2 or last)
+  const char* map = std::getenv("TA_TIER_MAP");
+  bool want_auto = !(map && std::strcmp(map, "static") == 0);
+  s.auto_map = want_auto && s.node_count > 1 && auto_tier_map(s);
+  if (!s.auto_map) {
+    int n0 = 0;
+    int n1 = (s.node_count > 1) ? 1 : 0;
+    int n2 = (s.node_count > 2) ? 2 : n1;
+    set_tier(s, 0, &n0, 1);
+    set_tier(s, 1, &n1, 1);
+    set_tier(s, 2, &n2, 1);
+  }
 
   // Env overrides
-  s.tier_node[0] = std::clamp(getenv_int("TA_NODE_FAST",   s.tier_node[0]), 0, std::max(0, s.max_node));
-  s.tier_node[1] = std::clamp(getenv_int("TA_NODE_NORMAL", s.tier_node[1]), 0, std::max(0, s.max_node));
-  s.tier_node[2] = std::clamp(getenv_int("TA_NODE_SLOW",   s.tier_node[2]), 0, std::max(0, s.max_node));
+  const char* single[3] = {"TA_NODE_FAST", "TA_NODE_NORMAL", "TA_NODE_SLOW"};
+  for (int t = 0; t < 3; ++t) {
+    if (!std::getenv(single[t])) continue;
+    int n = std::clamp(getenv_int(single[t], s.tier_node[t]), 0, std::max(0, s.max_node));
+    set_tier(s, t, &n, 1);
+  }
+
+  // Node sets per tier (TA_NODES_<TIER> replaces whatever the mapping chose)
+  load_tier_nodes(s, 0, "FAST");
+  load_tier_nodes(s, 1, "NORMAL");
+  load_tier_nodes(s, 2, "SLOW");
 
   // Choose libnuma path
   const char* use = std::getenv("TA_USE_LIBNUMA");
@@ -73,8 +282,21 @@ void ta_numa_init_from_env() {
   __ta_set_backend(s.backend);
   __ta_set_node_mapping(s.tier_node[0], s.tier_node[1], s.tier_node[2]);
   __ta_set_node_count(s.node_count);
+  for (int t = 0; t < 3; ++t) __ta_set_tier_nodes(t, s.tier_nodes[t], s.tier_nnodes[t]);
+  __ta_place_rebuild();
 }
 
 const ta_numa_info& ta_numa_probe() {
   return state();
 }
+
+int ta_numa_cpu_node(int cpu) {
+  return (cpu >= 0 && cpu < CPU_SETSIZE) ? g_cpu_node[cpu] : -1;
+}
+
+bool ta_numa_node_cpus(int node, cpu_set_t* out) {
+  const auto& s = state();
+  if (!out || node < 0 || node >= s.node_count || node >= TA_NUMA_MAX_NODES) return false;
+  *out = s.node_cpus[node];
+  return CPU_COUNT(out) > 0;
+}
@@ -0,0 +1,278 @@
+// Physical placement of tier ranges (mbind to the tier's node set)
+#include "numa_probe.h"
+#include "tieralloc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <vector>
+#include <unistd.h>
+
+#if defined(TA_HAVE_LIBNUMA)
+#include <numaif.h>
+#endif
+
+#ifndef MPOL_WEIGHTED_INTERLEAVE
+#define MPOL_WEIGHTED_INTERLEAVE 6
+#endif
+
+extern "C" void __ta_bytes_node_add(int node, long long delta);
+extern "C" void __ta_inc_place_failure(void);
+struct ta_placement;
+extern "C" int __ta_place_range_ex(void* p, unsigned long long len, const ta_placement* pl, bool move);
+
+// Immutable description of how one tier lays out pages. Allocation records keep a
+// pointer to the descriptor they were placed with, so frees account against the
+// same nodes even if the tier map is rebuilt later. Old descriptors are never freed.
+struct ta_placement {
+  ta_place_mode mode;
+  std::vector<int> nodes;
+  std::vector<unsigned> weights;   // pages per node and interleave cycle (kernel's), parallel to nodes
+  std::vector<int> order;          // indices into nodes by ascending id: the kernel's interleave order
+};
+
+namespace {
+
+std::atomic<const ta_placement*> g_tier_pl[3];
+std::atomic<const ta_placement*> g_node_pl[TA_NUMA_MAX_NODES];  // single-node, for locality
+
+constexpr unsigned kMaskBits = 8 * sizeof(unsigned long);
+
+constexpr const char* kWeightDir = "/sys/kernel/mm/mempolicy/weighted_interleave";
+
+// Kernel weighted interleave (Linux 6.9+) takes its weights from sysfs, per node
+bool kernel_weights(const std::vector<int>& nodes, std::vector<unsigned>& out) {
+  if (access(kWeightDir, F_OK) != 0) return false;
+  out.assign(nodes.size(), 1);
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    char path[96];
+    std::snprintf(path, sizeof(path), "%s/node%d", kWeightDir, nodes[i]);
+    if (FILE* f = std::fopen(path, "r")) {
+      unsigned w = 0;
+      if (std::fscanf(f, "%u", &w) == 1 && w > 0) out[i] = w;
+      std::fclose(f);
+    }
+  }
+  return true;
+}
+
+// A weighted tier's nodes and weights, leaving out nodes weighted 0
+void weighted_set(const ta_numa_info& s, int t, std::vector<int>& nodes, std::vector<unsigned>& w) {
+  for (int i = 0; i < s.tier_nnodes[t]; ++i) {
+    if (!s.tier_weights[t][i]) continue;
+    nodes.push_back(s.tier_nodes[t][i]);
+    w.push_back(s.tier_weights[t][i]);
+  }
+}
+
+// Install a weighted tier's weights (TA_WEIGHTS_* or calibrated) as the kernel's. They
+// are system-wide and root-only, so this is best effort: placement reads back whatever
+// the kernel ends up with. Weights go in lowest terms, scaled into the kernel's 1..255.
+void program_weights(const ta_numa_info& s, int t) {
+  if (s.tier_mode[t] != ta_place_mode::weighted || access(kWeightDir, W_OK) != 0) return;
+  std::vector<int> nodes;
+  std::vector<unsigned> w;
+  weighted_set(s, t, nodes, w);
+  if (nodes.size() < 2) return;
+  unsigned g = 0, hi = 0;
+  for (unsigned v : w) { g = std::gcd(g, v); hi = std::max(hi, v); }
+  hi /= g;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    unsigned v = w[i] / g;
+    if (hi > 255) v = std::max(1u, (unsigned)((unsigned long long)v * 255 / hi));
+    char path[96];
+    std::snprintf(path, sizeof(path), "%s/node%d", kWeightDir, nodes[i]);
+    unsigned cur = 0;
+    if (FILE* f = std::fopen(path, "r")) {
+      if (std::fscanf(f, "%u", &cur) != 1) cur = 0;
+      std::fclose(f);
+    }
+    if (cur == v) continue;
+    if (FILE* f = std::fopen(path, "w")) {
+      std::fprintf(f, "%u\n", v);
+      std::fclose(f);
+    }
+  }
+}
+
+// Weighted tiers are placed by MPOL_WEIGHTED_INTERLEAVE over the whole range, so
+// accounting follows the kernel's weights; without it they fall back to interleave
+const ta_placement* build(const ta_numa_info& s, int t) {
+  auto* pl = new ta_placement;
+  pl->mode = s.tier_mode[t];
+  pl->nodes.assign(s.tier_nodes[t], s.tier_nodes[t] + std::max(1, s.tier_nnodes[t]));
+  if (pl->mode == ta_place_mode::weighted) {
+    std::vector<int> nodes;
+    std::vector<unsigned> cfg;
+    weighted_set(s, t, nodes, cfg);
+    if (!nodes.empty()) pl->nodes = nodes;
+    if (pl->nodes.size() < 2 || !kernel_weights(pl->nodes, pl->weights)) pl->mode = ta_place_mode::interleave;
+  }
+  if (pl->nodes.size() == 1) pl->mode = ta_place_mode::preferred;
+  if (pl->mode != ta_place_mode::weighted) pl->weights.assign(pl->nodes.size(), 1);
+  pl->order.resize(pl->nodes.size());
+  std::iota(pl->order.begin(), pl->order.end(), 0);
+  std::sort(pl->order.begin(), pl->order.end(), [&](int a, int b) { return pl->nodes[a] < pl->nodes[b]; });
+  return pl;
+}
+
+inline unsigned long long base_page() {
+  static const unsigned long long page = (unsigned long long)sysconf(_SC_PAGESIZE);
+  return page;
+}
+
+// Visit the bytes of [addr, addr+len) each node holds. The kernel picks a page's node
+// from its interleave index, the page's number in the mapping (by address, for
+// anonymous memory, in units of the page size it faults): every cycle of sum(weights)
+// pages gives weights[k] consecutive pages to each node, in ascending node id order.
+template <class F>
+void for_each_share(const ta_placement* pl, uintptr_t addr, unsigned long long len, unsigned long long page, F&& fn) {
+  if (pl->mode == ta_place_mode::preferred) { fn(pl->nodes[0], len); return; }
+  unsigned long long total = 0;
+  for (unsigned w : pl->weights) total += w;
+  const unsigned long long cycle = total * page;
+  unsigned long long share[TA_NUMA_MAX_NODES]{};
+  // Offsets [from, to) within one cycle
+  auto span = [&](unsigned long long from, unsigned long long to) {
+    unsigned long long lo = 0;
+    for (int k : pl->order) {
+      unsigned long long hi = lo + pl->weights[k] * page;
+      if (from < hi && lo < to) share[k] += std::min(hi, to) - std::max(lo, from);
+      lo = hi;
+    }
+  };
+  const unsigned long long head = addr % cycle;
+  const unsigned long long first = std::min(len, cycle - head);
+  span(head, head + first);
+  const unsigned long long rest = len - first;
+  for (size_t k = 0; k < pl->nodes.size(); ++k) share[k] += rest / cycle * pl->weights[k] * page;
+  span(0, rest % cycle);
+  for (size_t k = 0; k < pl->nodes.size(); ++k)
+    if (share[k]) fn(pl->nodes[k], share[k]);
+}
+
+#if defined(TA_HAVE_LIBNUMA)
+int bind_nodes(void* p, unsigned long long len, int mode, const int* nodes, size_t n, unsigned flags = 0) {
+  unsigned long mask[TA_NUMA_MAX_NODES / kMaskBits]{};
+  for (size_t i = 0; i < n; ++i) mask[nodes[i] / kMaskBits] |= 1ul << (nodes[i] % kMaskBits);
+  return mbind(p, (unsigned long)len, mode, mask, sizeof(mask) * 8 + 1, flags);
+}
+#endif
+
+} // namespace
+
+// (Re)build per-tier descriptors from the current topology; called after numa init.
+// Weights are written for every tier first, so a node shared by two weighted tiers
+// reads back the same (last written) weight in both.
+extern "C" void __ta_place_rebuild(void) {
+  const auto& s = ta_numa_probe();
+  for (int t = 0; t < 3; ++t) program_weights(s, t);
+  for (int t = 0; t < 3; ++t) g_tier_pl[t].store(build(s, t), std::memory_order_release);
+}
+
+// Current descriptor for a tier (built on demand if numa init has not run)
+extern "C" const ta_placement* __ta_tier_placement(ta_tier_t tier) {
+  const ta_placement* pl = g_tier_pl[(int)tier].load(std::memory_order_acquire);
+  if (pl) return pl;
+  const ta_placement* fresh = build(ta_numa_probe(), (int)tier);
+  if (g_tier_pl[(int)tier].compare_exchange_strong(pl, fresh, std::memory_order_acq_rel)) return fresh;
+  delete fresh;
+  return pl;
+}
+
+// Single-node descriptor (locality-aware placement picks a node per allocation)
+extern "C" const ta_placement* __ta_node_placement(int node) {
+  if (node < 0 || node >= TA_NUMA_MAX_NODES) return nullptr;
+  const ta_placement* pl = g_node_pl[node].load(std::memory_order_acquire);
+  if (pl) return pl;
+  auto* fresh = new ta_placement{ta_place_mode::preferred, {node}, {1}, {0}};
+  if (g_node_pl[node].compare_exchange_strong(pl, fresh, std::memory_order_acq_rel)) return fresh;
+  delete fresh;
+  return pl;
+}
+
+// First node of a descriptor: where its pages start and whose CPUs fault them in
+extern "C" int __ta_placement_home(const ta_placement* pl) {
+  return pl ? pl->nodes[0] : -1;
+}
+
+// True when every page of a range lands on the same node, wherever the range starts
+extern "C" bool __ta_placement_single_node(const ta_placement* pl) {
+  return pl && pl->mode == ta_place_mode::preferred;
+}
+
+// Node a tier's pages should live on (and whose CPUs should fault them in)
+extern "C" int __ta_tier_home_node(ta_tier_t tier) {
+  return __ta_tier_placement(tier)->nodes[0];
+}
+
+// True when ranges get a real memory policy (libnuma backend selected)
+extern "C" bool __ta_place_enabled(void) {
+#if defined(TA_HAVE_LIBNUMA)
+  const auto& s = ta_numa_probe();
+  return s.available && s.use_libnuma;
+#else
+  return false;
+#endif
+}
+
+// Apply a placement's memory policy to [p, p+len) before first touch.
+// Returns 0 if a policy was installed, 1 if placement is simulated, <0 on error.
+extern "C" int __ta_place_range(void* p, unsigned long long len, const ta_placement* pl) {
+  return __ta_place_range_ex(p, len, pl, false);
+}
+
+// Same, for a range that already has pages: move=true asks the kernel to migrate them
+// (MPOL_MF_MOVE) so they follow the new policy.
+extern "C" int __ta_place_range_ex(void* p, unsigned long long len, const ta_placement* pl, bool move) {
+  if (!p || len == 0 || !pl) return -1;
+  if (!__ta_place_enabled()) return 1;
+#if defined(TA_HAVE_LIBNUMA)
+  // One policy per range: per-stripe mbind would split it into one VMA per stripe
+  unsigned flags = move ? MPOL_MF_MOVE : 0;
+  int mode = MPOL_PREFERRED;
+  if (pl->mode == ta_place_mode::interleave) mode = MPOL_INTERLEAVE;
+  if (pl->mode == ta_place_mode::weighted) mode = MPOL_WEIGHTED_INTERLEAVE;
+  int rc = bind_nodes(p, len, mode, pl->nodes.data(), mode == MPOL_PREFERRED ? 1 : pl->nodes.size(), flags);
+  if (rc != 0 && mode == MPOL_WEIGHTED_INTERLEAVE)
+    rc = bind_nodes(p, len, MPOL_INTERLEAVE, pl->nodes.data(), pl->nodes.size(), flags);
+  if (rc != 0) { __ta_inc_place_failure(); return -2; }
+  return 0;
+#else
+  (void)move;
+  return 1;
+#endif
+}
+
+// Bind [p, p+len) strictly to one node (calibration, explicit node placement)
+extern "C" int __ta_place_node(void* p, unsigned long long len, int node) {
+  if (!p || len == 0 || node < 0 || node >= TA_NUMA_MAX_NODES) return -1;
+  if (!__ta_place_enabled()) return 1;
+#if defined(TA_HAVE_LIBNUMA)
+  return bind_nodes(p, len, MPOL_BIND, &node, 1) == 0 ? 0 : -2;
+#else
+  return 1;
+#endif
+}
+
+// Bytes one interleave cycle of a placement spans at the given page size; 0 when its
+// pages all go to one node
+extern "C" unsigned long long __ta_placement_cycle(const ta_placement* pl, unsigned long long page) {
+  if (!pl || pl->mode == ta_place_mode::preferred) return 0;
+  unsigned long long total = 0;
+  for (unsigned w : pl->weights) total += w;
+  return total * page;
+}
+
+// Per-node residency of [p, p+len), faulted in pages of `page` bytes (0: base page):
+// sign=+1 on alloc, -1 on free
+extern "C" void __ta_place_account(const ta_placement* pl, const void* p, unsigned long long len,
+                                   unsigned long long page, int sign) {
+  if (!pl) return;
+  for_each_share(pl, (uintptr_t)p, len, page ? page : base_page(), [&](int node, unsigned long long bytes) {
+    __ta_bytes_node_add(node, sign * (long long)bytes);
+  });
+}
@@ -1,14 +1,26 @@
 #include "tieralloc.h"
+#include "numa_probe.h"
+#include <sched.h>
 #include <cstdlib>
 #include <cctype>
+#include <cerrno>
 #include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 // Internal capacity model and helpers
 extern "C" unsigned long long __ta_bytes_current(int tier); // forward from stats
 extern "C" void __ta_set_capacity_soft(const unsigned long long soft[3]);
 extern "C" void __ta_set_capacity_hard(const unsigned long long hard[3]);
 extern "C" void __ta_inc_capacity_violation(int tier);
+extern "C" unsigned long long __ta_node_bytes_current(int node);
+extern "C" bool __ta_domain_fits(int d, int t, unsigned long long bytes, bool hard_only);
+extern "C" unsigned long long __ta_pressure_cap(int tier);
+extern "C" bool __ta_pressure_node_tight(int node);
+extern "C" void __ta_throttle_set_tier(ta_tier_t tier, double bw_Bps, long base_latency_ns);
+extern "C" void __ta_throttle_get_tier(ta_tier_t tier, double* bw_Bps, long* base_latency_ns);
 
 namespace {
 
@@ -18,9 +30,18 @@ struct CapConfig {
   unsigned long long soft[3]{0,0,0}; 
   unsigned long long hard[3]{0,0,0};
   HardCapAction on_hardcap{HardCapAction::RouteSlow};
+  unsigned long long node_hard[TA_NUMA_MAX_NODES]{};  // 0 = uncapped
+  bool locality{false};  // FAST/NORMAL follow the calling thread's node
+  unsigned long long version{0};
 };
 
-CapConfig g_cap;
+// Readers take the published snapshot with one acquire load and never lock.
+// Writers copy it, edit the copy and publish it under g_snap_mtx. Replaced
+// snapshots are kept, not freed: a reader may still hold one, and updates are
+// rare control-plane events, so the retained memory stays small.
+std::atomic<const CapConfig*> g_snap{nullptr};
+std::mutex g_snap_mtx;
+std::vector<const CapConfig*> g_snap_retired;
 
 // 1k, 64m, 8g style parsing
 static inline unsigned long long parse_size(const char* s, unsigned long long defv) {
@@ -35,21 +56,68 @@ static inline unsigned long long parse_size(const char* s, unsigned long long de
   return val;
 }
 
-static inline void load_caps_from_env() {
+static inline void load_caps_from_env(CapConfig& c) {
   // Soft
-  g_cap.soft[TA_TIER_FAST]   = parse_size(std::getenv("TA_FAST_SOFT"),   0);
-  g_cap.soft[TA_TIER_NORMAL] = parse_size(std::getenv("TA_NORMAL_SOFT"), 0);
-  g_cap.soft[TA_TIER_SLOW]   = parse_size(std::getenv("TA_SLOW_SOFT"),   0);
+  c.soft[TA_TIER_FAST]   = parse_size(std::getenv("TA_FAST_SOFT"),   0);
+  c.soft[TA_TIER_NORMAL] = parse_size(std::getenv("TA_NORMAL_SOFT"), 0);
+  c.soft[TA_TIER_SLOW]   = parse_size(std::getenv("TA_SLOW_SOFT"),   0);
   // Hard
-  g_cap.hard[TA_TIER_FAST]   = parse_size(std::getenv("TA_FAST_HARD"),   0);
-  g_cap.hard[TA_TIER_NORMAL] = parse_size(std::getenv("TA_NORMAL_HARD"), 0);
-  g_cap.hard[TA_TIER_SLOW]   = parse_size(std::getenv("TA_SLOW_HARD"),   0);
+  c.hard[TA_TIER_FAST]   = parse_size(std::getenv("TA_FAST_HARD"),   0);
+  c.hard[TA_TIER_NORMAL] = parse_size(std::getenv("TA_NORMAL_HARD"), 0);
+  c.hard[TA_TIER_SLOW]   = parse_size(std::getenv("TA_SLOW_HARD"),   0);
 
   const char* act = std::getenv("TA_ON_HARDCAP");
-  if (act && std::strcmp(act, "fail")==0) g_cap.on_hardcap = HardCapAction::Fail;
+  if (act && std::strcmp(act, "fail")==0) c.on_hardcap = HardCapAction::Fail;
 
-  __ta_set_capacity_soft(g_cap.soft);
-  __ta_set_capacity_hard(g_cap.hard);
+  // Per-node: TA_NODE_CAPS="0:8g,1:8g"
+  if (const char* nc = std::getenv("TA_NODE_CAPS")) {
+    const char* p = nc;
+    while (*p) {
+      char* end = nullptr;
+      long node = std::strtol(p, &end, 10);
+      if (end == p || *end != ':') break;
+      p = end + 1;
+      char tok[32]{};
+      size_t n = std::strcspn(p, ",");
+      std::memcpy(tok, p, std::min(n, sizeof(tok) - 1));
+      if (node >= 0 && node < TA_NUMA_MAX_NODES) c.node_hard[node] = parse_size(tok, 0);
+      p += n;
+      if (*p == ',') ++p;
+    }
+  }
+  const char* loc = std::getenv("TA_LOCALITY");
+  c.locality = (loc && *loc == '1');
+}
+
+void publish(CapConfig* next) {
+  const CapConfig* prev = g_snap.load(std::memory_order_relaxed);
+  next->version = prev ? prev->version + 1 : 1;
+  __ta_set_capacity_soft(next->soft);
+  __ta_set_capacity_hard(next->hard);
+  g_snap.store(next, std::memory_order_release);
+  if (prev) g_snap_retired.push_back(prev);
+}
+
+// Current snapshot; the environment is read once, on first use
+const CapConfig& caps() {
+  static std::once_flag once;
+  std::call_once(once, []{
+    auto* c = new CapConfig;
+    load_caps_from_env(*c);
+    std::scoped_lock lk(g_snap_mtx);
+    publish(c);
+  });
+  return *g_snap.load(std::memory_order_acquire);
+}
+
+// Copy-edit-publish; edits are serialized, readers see either snapshot whole
+template <class F>
+void update_caps(F&& edit) {
+  caps();   // the env snapshot goes first
+  std::scoped_lock lk(g_snap_mtx);
+  auto* next = new CapConfig(*g_snap.load(std::memory_order_relaxed));
+  edit(*next);
+  publish(next);
 }
 
 static inline ta_tier_t hint_to_tier(ta_hint_t hint) {
@@ -64,18 +132,32 @@ static inline ta_tier_t hint_to_tier(ta_hint_t hint) {
   }
 }
 
+// Tighter of two caps where 0 means uncapped
+static inline unsigned long long min_cap(unsigned long long a, unsigned long long b) {
+  if (!a) return b;
+  if (!b) return a;
+  return std::min(a, b);
+}
+
 // Try to select a tier that respects soft/hard caps
-// Returns final chosen tier (may be different than hinted)
-static inline ta_tier_t apply_caps(unsigned long long bytes, ta_tier_t want) {
+// Memory-pressure caps act like soft caps: they reroute, never fail
+// Returns final chosen tier (may be different than hinted), or -1 when no tier is
+// under its hard cap and TA_ON_HARDCAP=fail
+// The process caps and the allocating domain's caps must both hold
+static inline int apply_caps(unsigned long long bytes, ta_tier_t want, int domain) {
+  const CapConfig& c = caps();
   auto fits_soft = [&](int t){
-    if (g_cap.soft[t] == 0) return true;
+    if (!__ta_domain_fits(domain, t, bytes, false)) return false;
+    unsigned long long cap = min_cap(c.soft[t], __ta_pressure_cap(t));
+    if (cap == 0) return true;
     unsigned long long cur = __ta_bytes_current(t);
-    return (cur + bytes) <= g_cap.soft[t];
+    return (cur + bytes) <= cap;
   };
   auto fits_hard = [&](int t){
-    if (g_cap.hard[t] == 0) return true;
+    if (!__ta_domain_fits(domain, t, bytes, true)) return false;
+    if (c.hard[t] == 0) return true;
     unsigned long long cur = __ta_bytes_current(t);
-    return (cur + bytes) <= g_cap.hard[t];
+    return (cur + bytes) <= c.hard[t];
   };
 
   if (fits_hard(want) && fits_soft(want)) return want;
@@ -103,22 +185,142 @@ static inline ta_tier_t apply_caps(unsigned long long bytes, ta_tier_t want) {
     }
   }
 
-  if (g_cap.on_hardcap == HardCapAction::RouteSlow)
+  __ta_inc_capacity_violation(want);
+  if (c.on_hardcap == HardCapAction::RouteSlow)
     return TA_TIER_SLOW;
-  return want;
+  return -1;
+}
+
+// FAST -> the calling thread's node, NORMAL -> its nearest other CPU node, skipping
+// nodes at their cap or short of free memory. -1 leaves placement to the tier's configured node set.
+static inline int pick_local_node(unsigned long long bytes, ta_tier_t tier) {
+  const CapConfig& c = caps();
+  if (!c.locality || tier == TA_TIER_SLOW) return -1;
+  const auto& s = ta_numa_probe();
+  int local = ta_numa_cpu_node(sched_getcpu());
+  if (local < 0 || local >= TA_NUMA_MAX_NODES) return -1;
+  const int* order = s.nearest[local];
+  int n = s.nearest_count[local];
+  for (int i = (tier == TA_TIER_FAST) ? 0 : 1; i < n; ++i) {
+    int node = order[i];
+    if (__ta_pressure_node_tight(node)) continue;
+    if (c.node_hard[node] == 0) return node;
+    if (__ta_node_bytes_current(node) + bytes <= c.node_hard[node]) return node;
+  }
+  return -1;
 }
 
 } 
 
+// Shared "1k, 64m, 8g" parser for other modules' env knobs
+extern "C" unsigned long long __ta_parse_size(const char* s, unsigned long long defv) {
+  return parse_size(s, defv);
+}
+
+// Same syntax, but for values from the control socket: false on anything that is
+// not digits with an optional k/m/g suffix, or that overflows
+extern "C" bool __ta_parse_size_strict(const char* s, unsigned long long* out) {
+  if (!s || !std::isdigit((unsigned char)*s)) return false;
+  errno = 0;
+  char* end = nullptr;
+  unsigned long long val = std::strtoull(s, &end, 10);
+  if (errno == ERANGE) return false;
+  int shift = 0;
+  if (*end) {
+    char suf = std::tolower(*end);
+    shift = suf == 'k' ? 10 : suf == 'm' ? 20 : suf == 'g' ? 30 : -1;
+    if (shift < 0 || end[1]) return false;
+  }
+  if (val > (~0ull >> shift)) return false;
+  *out = val << shift;
+  return true;
+}
+
 extern "C" ta_tier_t __ta_pick_tier_from_hint(ta_hint_t hint) {
   return hint_to_tier(hint);
 }
 
-// Choose final tier considering hint + caps
-extern "C" ta_tier_t __ta_policy_pick_tier(unsigned long long bytes, ta_hint_t hint) {
-  static bool inited = false;
-  if (!inited) { load_caps_from_env(); inited = true; }
+// Choose final tier considering hint + process caps + the domain's caps; -1: fail it
+extern "C" int __ta_policy_pick_tier_in(unsigned long long bytes, ta_hint_t hint, int domain) {
   ta_tier_t want = hint_to_tier(hint);
-  return apply_caps(bytes, want);
+  return apply_caps(bytes, want, domain);
 }
 
+// Same, charging the calling thread's current domain
+extern "C" int __ta_policy_pick_tier(unsigned long long bytes, ta_hint_t hint) {
+  return __ta_policy_pick_tier_in(bytes, hint, ta_domain_current());
+}
+
+// Node for a tier in locality mode, or -1 for the tier's own placement
+extern "C" int __ta_policy_pick_node(unsigned long long bytes, ta_tier_t tier) {
+  return pick_local_node(bytes, tier);
+}
+
+
+// --- Runtime reconfiguration ---
+
+extern "C" int ta_get_caps(ta_caps_t* out) {
+  if (!out) return -1;
+  const CapConfig& c = caps();
+  for (int t = 0; t < 3; ++t) { out->soft[t] = c.soft[t]; out->hard[t] = c.hard[t]; }
+  out->on_hardcap = (c.on_hardcap == HardCapAction::Fail) ? TA_HARDCAP_FAIL : TA_HARDCAP_ROUTE_SLOW;
+  return 0;
+}
+
+extern "C" int ta_set_caps(const ta_caps_t* caps_in) {
+  if (!caps_in) return -1;
+  if (caps_in->on_hardcap != TA_HARDCAP_ROUTE_SLOW && caps_in->on_hardcap != TA_HARDCAP_FAIL) return -1;
+  update_caps([&](CapConfig& c) {
+    for (int t = 0; t < 3; ++t) { c.soft[t] = caps_in->soft[t]; c.hard[t] = caps_in->hard[t]; }
+    c.on_hardcap = (caps_in->on_hardcap == TA_HARDCAP_FAIL) ? HardCapAction::Fail : HardCapAction::RouteSlow;
+  });
+  return 0;
+}
+
+extern "C" int ta_set_node_cap(int node, unsigned long long hard) {
+  if (node < 0 || node >= TA_NUMA_MAX_NODES) return -1;
+  update_caps([&](CapConfig& c) { c.node_hard[node] = hard; });
+  return 0;
+}
+
+// Partial edit in one snapshot (control socket): `mask` picks the fields of caps_in
+// that change (bit t: soft[t], bit 3+t: hard[t], bit 6: on_hardcap), plus n node caps.
+// Applied to the current snapshot under the writer lock, so concurrent edits of other
+// fields are kept and readers never see half of it.
+extern "C" int __ta_edit_caps(const ta_caps_t* caps_in, unsigned mask, const int* nodes,
+                              const unsigned long long* node_hard, int n) {
+  if (!caps_in || n < 0 || (n && (!nodes || !node_hard))) return -1;
+  if ((mask & (1u << 6)) && caps_in->on_hardcap != TA_HARDCAP_ROUTE_SLOW && caps_in->on_hardcap != TA_HARDCAP_FAIL) return -1;
+  for (int i = 0; i < n; ++i)
+    if (nodes[i] < 0 || nodes[i] >= TA_NUMA_MAX_NODES) return -1;
+  update_caps([&](CapConfig& c) {
+    for (int t = 0; t < 3; ++t) {
+      if (mask & (1u << t)) c.soft[t] = caps_in->soft[t];
+      if (mask & (1u << (3 + t))) c.hard[t] = caps_in->hard[t];
+    }
+    if (mask & (1u << 6))
+      c.on_hardcap = (caps_in->on_hardcap == TA_HARDCAP_FAIL) ? HardCapAction::Fail : HardCapAction::RouteSlow;
+    for (int i = 0; i < n; ++i) c.node_hard[nodes[i]] = node_hard[i];
+  });
+  return 0;
+}
+
+// capacity_bytes is the tier's soft cap
+extern "C" int ta_get_tier_cfg(ta_tier_t tier, ta_tier_cfg_t* out) {
+  if ((int)tier < 0 || (int)tier > 2 || !out) return -1;
+  __ta_throttle_get_tier(tier, &out->bandwidth_Bps, &out->base_latency_ns);
+  out->capacity_bytes = caps().soft[tier];
+  return 0;
+}
+
+extern "C" int ta_set_tier_cfg(ta_tier_t tier, const ta_tier_cfg_t* cfg) {
+  if ((int)tier < 0 || (int)tier > 2 || !cfg || cfg->bandwidth_Bps <= 0.0 || cfg->base_latency_ns < 0) return -1;
+  __ta_throttle_set_tier(tier, cfg->bandwidth_Bps, cfg->base_latency_ns);
+  if (cfg->capacity_bytes != caps().soft[tier])
+    update_caps([&](CapConfig& c) { c.soft[tier] = cfg->capacity_bytes; });
+  return 0;
+}
+
+extern "C" unsigned long long ta_config_version(void) {
+  return caps().version;
+}
@@ -0,0 +1,119 @@
+// Small worker pool for bulk page work (prefault, copies), pinned per job to a node's CPUs
+#include "numa_probe.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+
+namespace {
+
+struct Job {
+  void (*fn)(unsigned idx, unsigned parts, void* arg);
+  void* arg;
+  unsigned parts;
+  int node;                          // <0: unpinned
+  unsigned next{0};                  // next part to claim; guarded by Pool::mtx
+  unsigned done{0};                  // guarded by Pool::mtx
+  std::condition_variable done_cv;
+};
+
+struct Pool {
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<Job*> q;
+  unsigned nthreads{0};
+  bool started{false};
+};
+
+void on_fork_child();
+
+// Leaked on purpose: workers outlive static destruction at exit
+Pool*& pool_ptr() {
+  static Pool* p = (pthread_atfork(nullptr, nullptr, on_fork_child), new Pool);
+  return p;
+}
+
+Pool& P() { return *pool_ptr(); }
+
+// The child has none of the workers, and the inherited condition variable still
+// counts them as waiting: start over with a fresh pool on first use (the old one leaks)
+void on_fork_child() { pool_ptr() = new Pool; }
+
+unsigned pool_size_from_env() {
+  unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  unsigned defv = std::min(hw, 8u);
+  if (const char* v = std::getenv("TA_POOL_THREADS")) return (unsigned)std::max(0, std::atoi(v));
+  return defv;
+}
+
+void pin_to_node(int node) {
+  cpu_set_t set;
+  if (node >= 0 && ta_numa_node_cpus(node, &set)) {
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    return;
+  }
+  // Unpinned: allow every CPU we can see
+  CPU_ZERO(&set);
+  for (int c = 0; c < CPU_SETSIZE; ++c) CPU_SET(c, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+void worker_main() {
+  auto& p = P();
+  int cur_node = -2;
+  for (;;) {
+    Job* job = nullptr;
+    unsigned idx = 0;
+    {
+      std::unique_lock lk(p.mtx);
+      p.cv.wait(lk, [&]{ return !p.q.empty(); });
+      job = p.q.front();
+      idx = job->next++;
+      // Last part claimed: retire the job so nobody touches it after the caller returns
+      if (job->next == job->parts) p.q.pop_front();
+    }
+    if (job->node != cur_node) { pin_to_node(job->node); cur_node = job->node; }
+    job->fn(idx, job->parts, job->arg);
+    {
+      std::scoped_lock lk(p.mtx);
+      if (++job->done == job->parts) job->done_cv.notify_all();
+    }
+  }
+}
+
+void start_locked(Pool& p) {
+  p.started = true;
+  p.nthreads = pool_size_from_env();
+  for (unsigned i = 0; i < p.nthreads; ++i) std::thread(worker_main).detach();
+}
+
+} // namespace
+
+// Number of workers (starts the pool on first use); 0 means work runs inline
+extern "C" unsigned __ta_pool_threads(void) {
+  auto& p = P();
+  std::scoped_lock lk(p.mtx);
+  if (!p.started) start_locked(p);
+  return p.nthreads;
+}
+
+// Run fn(i, parts, arg) for i in [0, parts) on workers pinned to node; blocks until done.
+// Runs inline on the caller if the pool is disabled or there is a single part.
+extern "C" void __ta_pool_run(int node, unsigned parts, void (*fn)(unsigned, unsigned, void*), void* arg) {
+  if (!fn || parts == 0) return;
+  if (parts == 1 || __ta_pool_threads() == 0) {
+    for (unsigned i = 0; i < parts; ++i) fn(i, parts, arg);
+    return;
+  }
+  auto& p = P();
+  Job job;
+  job.fn = fn; job.arg = arg; job.parts = parts; job.node = node;
+  std::unique_lock lk(p.mtx);
+  p.q.push_back(&job);
+  p.cv.notify_all();
+  job.done_cv.wait(lk, [&]{ return job.done == job.parts; });
+}
@@ -0,0 +1,255 @@
+// Memory-pressure feedback (TA_PRESSURE=1): a monitor thread samples PSI
+// (/proc/pressure/memory) and per-node free memory, and turns them into
+//  - effective FAST/NORMAL caps: what is placed now plus the free memory left
+//    above a per-node reserve, so growth stops before the node starts reclaiming;
+//  - tight nodes, which locality placement skips;
+//  - demotion of the longest resident allocations on nodes below their reserve
+//    (only where the next tier lives on other nodes). Each sample moves at most
+//    TA_PRESSURE_STEP per node, and only this process's share of the deficit;
+//    if a round did not shrink the deficit, the node backs off for 1, 2, 4 ...
+//    up to 64 samples.
+// While PSI "some avg10" is at or above TA_PRESSURE_PSI the reserve doubles.
+#include "numa_probe.h"
+#include "tieralloc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+#include <unistd.h>
+
+extern "C" unsigned long long __ta_parse_size(const char* s, unsigned long long defv);
+extern "C" unsigned long long __ta_bytes_current(int tier);
+extern "C" unsigned long long __ta_node_bytes_current(int node);
+extern "C" unsigned long long __ta_local_node_bytes_current(int node);
+extern "C" unsigned long long __ta_demote_tier(int tier, int node, unsigned long long need);
+
+namespace {
+
+constexpr unsigned long long kNoCap = ~0ull;
+
+struct Monitor {
+  std::atomic<bool> on{false};
+  std::atomic<unsigned long long> cap[3]{kNoCap, kNoCap, kNoCap};
+  std::atomic<bool> tight[TA_NUMA_MAX_NODES]{};
+  std::atomic<unsigned> psi_x100{0};          // last "some avg10", percent * 100
+  std::atomic<unsigned long long> demoted_bytes{0};
+  std::atomic<unsigned long long> samples{0};
+
+  unsigned interval_ms{1000};
+  unsigned long long min_free{0};             // 0 = 5% of the node's MemTotal
+  double psi_threshold{10.0};
+  unsigned long long step{256ull << 20};      // most demoted per node and sample
+
+  // Demotion feedback per node, touched by the sampling thread only
+  unsigned long long last_deficit[TA_NUMA_MAX_NODES]{};
+  unsigned long long last_demoted[TA_NUMA_MAX_NODES]{};
+  unsigned backoff[TA_NUMA_MAX_NODES]{};
+  unsigned skip[TA_NUMA_MAX_NODES]{};
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stop{false};
+  std::thread* thr{nullptr};
+};
+
+// Function-local so it is constructed before the library constructor's init runs.
+// Never destroyed: a forked child inherits the condition variable with the parent's
+// monitor waiting on it, and destroying that at the child's exit would block.
+Monitor& M() { static Monitor* m = new Monitor; return *m; }
+
+// Small /proc and /sys reads go through read(2) into a stack buffer rather than stdio
+int read_file(const char* path, char* buf, size_t n) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -1;
+  ssize_t r = read(fd, buf, n - 1);
+  close(fd);
+  if (r < 0) return -1;
+  buf[r] = '\0';
+  return (int)r;
+}
+
+// -1 if PSI is unavailable (kernel without CONFIG_PSI, or psi=0)
+double read_psi_some_avg10() {
+  char buf[256];
+  if (read_file("/proc/pressure/memory", buf, sizeof(buf)) < 0) return -1.0;
+  const char* p = std::strstr(buf, "some avg10=");
+  return p ? std::strtod(p + 11, nullptr) : -1.0;
+}
+
+// MemTotal / MemFree of one node in bytes; false if the node has no meminfo
+bool read_node_mem(int node, unsigned long long* total, unsigned long long* free_b) {
+  char path[64], buf[4096];
+  std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", node);
+  if (read_file(path, buf, sizeof(buf)) < 0) return false;
+  const char* t = std::strstr(buf, "MemTotal:");
+  const char* f = std::strstr(buf, "MemFree:");
+  if (!t || !f) return false;
+  *total = std::strtoull(t + 9, nullptr, 10) << 10;
+  *free_b = std::strtoull(f + 8, nullptr, 10) << 10;
+  return true;
+}
+
+bool in_tier(const ta_numa_info& s, int tier, int node) {
+  for (int i = 0; i < s.tier_nnodes[tier]; ++i)
+    if (s.tier_nodes[tier][i] == node) return true;
+  return false;
+}
+
+// Demote this process's share of a tight node's deficit out of tier t
+unsigned long long relieve(int t, int n, unsigned long long deficit) {
+  auto& m = M();
+  if (m.last_demoted[n]) {
+    // It helped if the deficit fell by at least half of what moved; if not, the memory
+    // is held outside tieralloc (or was never touched) and more demotion is wasted
+    bool helped = deficit + m.last_demoted[n] / 2 <= m.last_deficit[n];
+    m.backoff[n] = helped ? 0 : std::min(m.backoff[n] ? m.backoff[n] * 2 : 1, 64u);
+    m.skip[n] = m.backoff[n];
+  }
+  m.last_deficit[n] = deficit;
+  m.last_demoted[n] = 0;
+  if (m.skip[n]) { --m.skip[n]; return 0; }
+
+  // With TA_SHARED every process on the node sees the same deficit: each takes its part
+  unsigned long long mine = __ta_local_node_bytes_current(n);
+  unsigned long long all = std::max(__ta_node_bytes_current(n), mine);
+  if (!mine) return 0;
+  unsigned long long need = (unsigned long long)((long double)deficit * mine / all);
+  need = std::min({need ? need : 1, mine, m.step});
+  // Only kernel page moves run here, off the owners' threads; if none went through,
+  // the pages stay put and the node backs off as if demotion had not helped
+  m.last_demoted[n] = __ta_demote_tier(t, n, need);
+  if (!m.last_demoted[n]) m.skip[n] = m.backoff[n] = std::min(m.backoff[n] ? m.backoff[n] * 2 : 1, 64u);
+  return m.last_demoted[n];
+}
+
+void sample() {
+  const auto& s = ta_numa_probe();
+  double psi = read_psi_some_avg10();
+  M().psi_x100.store(psi > 0 ? (unsigned)(psi * 100.0) : 0, std::memory_order_relaxed);
+  const unsigned scale = (psi >= M().psi_threshold) ? 2 : 1;
+
+  unsigned long long headroom[TA_NUMA_MAX_NODES]{};  // free above the reserve
+  unsigned long long deficit[TA_NUMA_MAX_NODES]{};   // reserve not covered by free
+  bool known[TA_NUMA_MAX_NODES]{};
+  const int nodes = s.node_count < TA_NUMA_MAX_NODES ? s.node_count : TA_NUMA_MAX_NODES;
+  for (int n = 0; n < nodes; ++n) {
+    unsigned long long total = 0, free_b = 0;
+    if (!read_node_mem(n, &total, &free_b) || total == 0) continue;
+    unsigned long long reserve = (M().min_free ? M().min_free : total / 20) * scale;
+    known[n] = true;
+    headroom[n] = free_b > reserve ? free_b - reserve : 0;
+    deficit[n] = free_b < reserve ? reserve - free_b : 0;
+    M().tight[n].store(deficit[n] != 0, std::memory_order_relaxed);
+  }
+
+  // SLOW is the last resort and keeps its configured caps only
+  for (int t = TA_TIER_FAST; t <= TA_TIER_NORMAL; ++t) {
+    unsigned long long room = 0;
+    bool any = false;
+    for (int i = 0; i < s.tier_nnodes[t]; ++i) {
+      int n = s.tier_nodes[t][i];
+      if (n < 0 || n >= nodes || !known[n]) continue;
+      any = true;
+      room += headroom[n];
+      if (!deficit[n]) { M().last_demoted[n] = M().backoff[n] = M().skip[n] = 0; continue; }
+      // Demoting onto the same node would not relieve it
+      if (!in_tier(s, t + 1, n))
+        M().demoted_bytes.fetch_add(relieve(t, n, deficit[n]), std::memory_order_relaxed);
+    }
+    M().cap[t].store(any ? __ta_bytes_current(t) + room : kNoCap, std::memory_order_relaxed);
+  }
+  M().samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void run() {
+  std::unique_lock lk(M().mtx);
+  while (!M().stop) {
+    lk.unlock();
+    sample();
+    lk.lock();
+    M().cv.wait_for(lk, std::chrono::milliseconds(M().interval_ms), [] { return M().stop; });
+  }
+}
+
+void stop_monitor() {
+  if (!M().thr) return;
+  {
+    std::scoped_lock lk(M().mtx);
+    M().stop = true;
+  }
+  M().cv.notify_all();
+  if (M().thr && M().thr->joinable()) M().thr->join();
+  M().on.store(false, std::memory_order_relaxed);
+}
+
+// The monitor thread stayed in the parent: its caps would freeze, so the child runs
+// without pressure feedback
+void on_fork_child() {
+  M().thr = nullptr;
+  M().on.store(false, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// Start the monitor if TA_PRESSURE=1; knobs: TA_PRESSURE_INTERVAL_MS (default 1000),
+// TA_PRESSURE_MIN_FREE (per-node reserve, default 5% of the node), TA_PRESSURE_PSI (default 10),
+// TA_PRESSURE_STEP (most demoted per node and sample, default 256M)
+extern "C" int __ta_pressure_init(void) {
+  const char* v = std::getenv("TA_PRESSURE");
+  if (!v || *v != '1') return 1;
+  if (const char* iv = std::getenv("TA_PRESSURE_INTERVAL_MS")) {
+    long ms = std::strtol(iv, nullptr, 10);
+    if (ms > 0) M().interval_ms = (unsigned)ms;
+  }
+  M().min_free = __ta_parse_size(std::getenv("TA_PRESSURE_MIN_FREE"), 0);
+  if (const char* pv = std::getenv("TA_PRESSURE_PSI")) M().psi_threshold = std::strtod(pv, nullptr);
+  M().step = __ta_parse_size(std::getenv("TA_PRESSURE_STEP"), M().step);
+
+  // First sample inline so caps hold from the first allocation on
+  sample();
+  M().on.store(true, std::memory_order_relaxed);
+  M().thr = new std::thread(run);   // never freed: joined at exit, may outlive statics
+  std::atexit(stop_monitor);
+  pthread_atfork(nullptr, nullptr, on_fork_child);
+  return 0;
+}
+
+extern "C" bool __ta_pressure_enabled(void) {
+  return M().on.load(std::memory_order_relaxed);
+}
+
+// Effective cap from memory pressure; 0 when unconstrained (same convention as TA_*_HARD)
+extern "C" unsigned long long __ta_pressure_cap(int tier) {
+  if (!M().on.load(std::memory_order_relaxed)) return 0;
+  unsigned long long c = M().cap[tier].load(std::memory_order_relaxed);
+  if (c == kNoCap) return 0;
+  return c ? c : 1;   // a cap of 0 bytes must still read as a cap
+}
+
+extern "C" bool __ta_pressure_node_tight(int node) {
+  if (!M().on.load(std::memory_order_relaxed) || node < 0 || node >= TA_NUMA_MAX_NODES) return false;
+  return M().tight[node].load(std::memory_order_relaxed);
+}
+
+// JSON object for ta_stats_json
+extern "C" int __ta_pressure_json(char* buf, unsigned long long n) {
+  if (!M().on.load(std::memory_order_relaxed)) return std::snprintf(buf, n, "{\"enabled\":false}");
+  unsigned long long c[2];
+  for (int t = 0; t < 2; ++t) c[t] = __ta_pressure_cap(t);
+  int tight = 0;
+  for (const auto& x : M().tight) tight += x.load(std::memory_order_relaxed);
+  return std::snprintf(buf, n,
+      "{\"enabled\":true,\"psi_some_avg10\":%.2f,\"effective_caps\":[ %llu, %llu, 0 ],"
+      "\"tight_nodes\":%d,\"demoted_bytes\":%llu,\"samples\":%llu}",
+      M().psi_x100.load(std::memory_order_relaxed) / 100.0, c[0], c[1], tight,
+      M().demoted_bytes.load(std::memory_order_relaxed),
+      M().samples.load(std::memory_order_relaxed));
+}
@@ -0,0 +1,121 @@
+// Region (bump-pointer) allocator: per-iteration scratch carved out of large tier
+// chunks. Nothing is freed individually; reset rewinds and keeps the pages resident.
+#include "tieralloc.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <vector>
+
+namespace {
+
+struct Chunk {
+    char* base;
+    unsigned long long size;
+};
+
+// Hint that asks the policy for exactly this tier
+ta_hint_t tier_hint(ta_tier_t tier) {
+    switch (tier) {
+        case TA_TIER_FAST: return TA_HINT_PIN_FAST;
+        case TA_TIER_SLOW: return TA_HINT_COLD;
+        default:           return TA_HINT_WARM;
+    }
+}
+
+} // namespace
+
+struct ta_region {
+    ta_hint_t hint;
+    unsigned flags;
+    unsigned long long reserve;
+    std::vector<Chunk> chunks;
+    size_t cur{0};
+    char* ptr{nullptr};                  // bump pointer inside chunks[cur]
+    char* end{nullptr};
+    unsigned long long used_before{0};   // bytes consumed in chunks before cur
+};
+
+namespace {
+
+bool add_chunk(ta_region* r, unsigned long long size) {
+    void* p = ta_alloc_ex(size, r->hint, r->flags);
+    if (!p) return false;
+    r->chunks.push_back(Chunk{static_cast<char*>(p), size});
+    return true;
+}
+
+void enter_chunk(ta_region* r, size_t i) {
+    if (r->ptr) r->used_before += (unsigned long long)(r->ptr - r->chunks[r->cur].base);
+    r->cur = i;
+    r->ptr = r->chunks[i].base;
+    r->end = r->ptr + r->chunks[i].size;
+}
+
+inline char* align_up(char* p, unsigned long long align) {
+    return (char*)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+}
+
+} // namespace
+
+extern "C" ta_region_t* ta_region_create(ta_tier_t tier, unsigned long long reserve, unsigned flags) {
+    if (reserve == 0) return nullptr;
+    auto* r = new (std::nothrow) ta_region;
+    if (!r) return nullptr;
+    r->hint = tier_hint(tier);
+    r->flags = flags;
+    r->reserve = reserve;
+    if (!add_chunk(r, reserve)) { delete r; return nullptr; }
+    enter_chunk(r, 0);
+    return r;
+}
+
+extern "C" void* ta_region_alloc(ta_region_t* r, unsigned long long bytes, unsigned long long align) {
+    if (!r) return nullptr;
+    if (align == 0) align = 16;
+    if (align & (align - 1)) return nullptr;
+    char* p = align_up(r->ptr, align);
+    if (p <= r->end && bytes <= (unsigned long long)(r->end - p)) {
+        r->ptr = p + bytes;
+        return p;
+    }
+    // Slow path: next chunk that fits (kept from earlier iterations), else grow
+    for (size_t i = r->cur + 1; i < r->chunks.size(); ++i) {
+        if (bytes + align <= r->chunks[i].size) {
+            enter_chunk(r, i);
+            p = align_up(r->ptr, align);
+            r->ptr = p + bytes;
+            return p;
+        }
+    }
+    unsigned long long want = bytes + align;
+    if (!add_chunk(r, want > r->reserve ? want : r->reserve)) return nullptr;
+    enter_chunk(r, r->chunks.size() - 1);
+    p = align_up(r->ptr, align);
+    r->ptr = p + bytes;
+    return p;
+}
+
+extern "C" void ta_region_reset(ta_region_t* r) {
+    if (!r) return;
+    r->cur = 0;
+    r->ptr = r->chunks[0].base;
+    r->end = r->ptr + r->chunks[0].size;
+    r->used_before = 0;
+}
+
+extern "C" void ta_region_destroy(ta_region_t* r) {
+    if (!r) return;
+    for (const Chunk& c : r->chunks) ta_free(c.base);
+    delete r;
+}
+
+extern "C" void ta_region_usage(const ta_region_t* r, unsigned long long* used, unsigned long long* reserved) {
+    if (!r) return;
+    if (used) *used = r->used_before + (unsigned long long)(r->ptr - r->chunks[r->cur].base);
+    if (reserved) {
+        unsigned long long total = 0;
+        for (const Chunk& c : r->chunks) total += c.size;
+        *reserved = total;
+    }
+}
@@ -0,0 +1,269 @@
+// Host-wide residency accounting (TA_SHARED=1): every tieralloc process on the box
+// adds its per-tier and per-node bytes to one shared-memory segment, so caps are
+// checked against what all of them hold together. Each process also owns a slot
+// with its own share; slots of processes that died are swept back out of the totals
+// by a background thread (and on attach and stats), never inside an allocation.
+#include "numa_probe.h"
+#include "tieralloc.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+extern "C" unsigned long long __ta_local_bytes_current(int tier);
+extern "C" unsigned long long __ta_local_node_bytes_current(int node);
+
+namespace {
+
+constexpr uint32_t kMagic = 0x54415348;   // "TASH"
+constexpr uint32_t kVersion = 1;
+constexpr int kSlots = 256;
+
+struct Slot {
+  int32_t pid;                   // 0 free, -1 being reclaimed
+  uint32_t pad;
+  uint64_t start;                // /proc/<pid>/stat starttime, guards against pid reuse
+  uint64_t tier[3];
+  uint64_t node[TA_NUMA_MAX_NODES];
+};
+
+struct Segment {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t last_sweep_ns;
+  uint64_t tier[3];
+  uint64_t node[TA_NUMA_MAX_NODES];
+  Slot slots[kSlots];
+};
+
+Segment* g_seg = nullptr;
+Slot* g_slot = nullptr;
+std::atomic<bool> g_on{false};
+
+template <class T>
+inline std::atomic_ref<T> A(T& v) { return std::atomic_ref<T>(v); }
+
+// Add a signed delta without wrapping below zero
+void add_clamped(uint64_t& v, long long delta) {
+  auto a = A(v);
+  if (delta >= 0) { a.fetch_add((uint64_t)delta, std::memory_order_relaxed); return; }
+  uint64_t d = (uint64_t)(-delta), cur = a.load(std::memory_order_relaxed);
+  while (!a.compare_exchange_weak(cur, d > cur ? 0 : cur - d, std::memory_order_relaxed)) {}
+}
+
+// Plain open/read into a stack buffer: also runs in a forked child (see on_fork_child)
+uint64_t proc_start_time(int pid) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return 0;
+  char buf[1024];
+  ssize_t n = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+  if (n < 0) return 0;
+  buf[n] = '\0';
+  // Fields after the parenthesised comm; starttime is field 22
+  const char* p = std::strrchr(buf, ')');
+  if (!p) return 0;
+  int field = 2;
+  for (; *p && field < 22; ++p) if (*p == ' ') ++field;
+  return std::strtoull(p, nullptr, 10);
+}
+
+bool slot_dead(const Slot& s, int pid) {
+  if (kill(pid, 0) != 0 && errno == ESRCH) return true;
+  uint64_t start = A(const_cast<Slot&>(s).start).load(std::memory_order_acquire);
+  return start != 0 && proc_start_time(pid) != start;
+}
+
+// Take a dead process's share back out of the totals and free its slot
+void reclaim(Slot& s, int32_t pid) {
+  if (!A(s.pid).compare_exchange_strong(pid, -1, std::memory_order_acq_rel)) return;
+  for (int t = 0; t < 3; ++t)
+    add_clamped(g_seg->tier[t], -(long long)A(s.tier[t]).exchange(0, std::memory_order_relaxed));
+  for (int n = 0; n < TA_NUMA_MAX_NODES; ++n)
+    add_clamped(g_seg->node[n], -(long long)A(s.node[n]).exchange(0, std::memory_order_relaxed));
+  A(s.start).store(0, std::memory_order_relaxed);
+  A(s.pid).store(0, std::memory_order_release);
+}
+
+void sweep() {
+  for (Slot& s : g_seg->slots) {
+    int32_t pid = A(s.pid).load(std::memory_order_acquire);
+    if (pid > 0 && &s != g_slot && slot_dead(s, pid)) reclaim(s, pid);
+  }
+}
+
+// At most one sweep per second across all processes
+void maybe_sweep() {
+  uint64_t now = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  auto last = A(g_seg->last_sweep_ns);
+  uint64_t prev = last.load(std::memory_order_relaxed);
+  if (now - prev < 1000000000ull && prev <= now) return;
+  if (!last.compare_exchange_strong(prev, now, std::memory_order_relaxed)) return;
+  sweep();
+}
+
+struct Sweeper {
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stop{false};
+  std::thread* thr{nullptr};
+};
+
+// Function-local so it is constructed before the library constructor's init runs.
+// Never destroyed: a forked child inherits the condition variable with the parent's
+// sweeper waiting on it, and destroying that at the child's exit would block.
+Sweeper& W() { static Sweeper* w = new Sweeper; return *w; }
+
+void sweeper_run() {
+  std::unique_lock lk(W().mtx);
+  while (!W().cv.wait_for(lk, std::chrono::seconds(1), [] { return W().stop; })) {
+    lk.unlock();
+    maybe_sweep();
+    lk.lock();
+  }
+}
+
+void stop_sweeper() {
+  if (!W().thr) return;
+  {
+    std::scoped_lock lk(W().mtx);
+    W().stop = true;
+  }
+  W().cv.notify_all();
+  if (W().thr->joinable()) W().thr->join();
+}
+
+// Claim a free slot for this process and bring in what it already holds
+bool claim_slot() {
+  const int32_t me = getpid();
+  for (Slot& s : g_seg->slots) {
+    int32_t zero = 0;
+    if (!A(s.pid).compare_exchange_strong(zero, me, std::memory_order_acq_rel)) continue;
+    A(s.start).store(proc_start_time(me), std::memory_order_release);
+    g_slot = &s;
+    break;
+  }
+  if (!g_slot) return false;
+  for (int t = 0; t < 3; ++t) {
+    uint64_t b = __ta_local_bytes_current(t);
+    add_clamped(g_slot->tier[t], (long long)b);
+    add_clamped(g_seg->tier[t], (long long)b);
+  }
+  for (int n = 0; n < TA_NUMA_MAX_NODES; ++n) {
+    uint64_t b = __ta_local_node_bytes_current(n);
+    add_clamped(g_slot->node[n], (long long)b);
+    add_clamped(g_seg->node[n], (long long)b);
+  }
+  return true;
+}
+
+// A forked child inherits the parent's slot pointer and its mappings. It takes a slot
+// of its own for what it inherited, so its frees come out of its own share and the
+// parent's exit does not reclaim the child's bytes. The sweeper stayed in the parent.
+void on_fork_child() {
+  W().thr = nullptr;
+  if (!g_on.exchange(false, std::memory_order_relaxed)) return;
+  g_slot = nullptr;
+  if (claim_slot()) g_on.store(true, std::memory_order_release);
+}
+
+void detach() {
+  if (!g_on.exchange(false) || !g_slot) return;
+  int32_t pid = getpid();
+  reclaim(*g_slot, pid);
+  g_slot = nullptr;
+}
+
+} // namespace
+
+// Map the segment and claim a slot; TA_SHARED=1 (segment /tieralloc) or a custom name
+extern "C" int __ta_shared_init(void) {
+  const char* v = std::getenv("TA_SHARED");
+  if (!v || !*v || std::strcmp(v, "0") == 0) return 1;
+  const char* name = (std::strcmp(v, "1") == 0) ? "/tieralloc" : v;
+
+  int fd = shm_open(name, O_RDWR | O_CREAT, 0660);
+  if (fd < 0) return -1;
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || ((size_t)st.st_size < sizeof(Segment) && ftruncate(fd, sizeof(Segment)) != 0)) {
+    close(fd);
+    return -1;
+  }
+  void* p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return -1;
+  auto* seg = static_cast<Segment*>(p);
+
+  // A fresh segment is all zeroes, which is already a valid empty state
+  uint32_t expect = 0;
+  if (!A(seg->magic).compare_exchange_strong(expect, kMagic) && expect != kMagic) {
+    munmap(p, sizeof(Segment));
+    return -2;
+  }
+  expect = 0;
+  if (!A(seg->version).compare_exchange_strong(expect, kVersion) && expect != kVersion) {
+    munmap(p, sizeof(Segment));
+    return -2;
+  }
+  g_seg = seg;
+  sweep();
+  if (!claim_slot()) { g_seg = nullptr; munmap(p, sizeof(Segment)); return -3; }
+
+  g_on.store(true, std::memory_order_release);
+  std::atexit(detach);
+  pthread_atfork(nullptr, nullptr, on_fork_child);
+  W().thr = new std::thread(sweeper_run);   // never freed: joined at exit
+  std::atexit(stop_sweeper);
+  return 0;
+}
+
+extern "C" bool __ta_shared_enabled(void) {
+  return g_on.load(std::memory_order_relaxed);
+}
+
+extern "C" void __ta_shared_tier_add(int tier, long long delta) {
+  if (!g_on.load(std::memory_order_relaxed) || delta == 0) return;
+  add_clamped(g_slot->tier[tier], delta);
+  add_clamped(g_seg->tier[tier], delta);
+}
+
+extern "C" void __ta_shared_node_add(int node, long long delta) {
+  if (!g_on.load(std::memory_order_relaxed) || node < 0 || node >= TA_NUMA_MAX_NODES || delta == 0) return;
+  add_clamped(g_slot->node[node], delta);
+  add_clamped(g_seg->node[node], delta);
+}
+
+// Host-wide residency for cap checks
+extern "C" unsigned long long __ta_shared_tier_bytes(int tier) {
+  return A(g_seg->tier[tier]).load(std::memory_order_relaxed);
+}
+
+extern "C" unsigned long long __ta_shared_node_bytes(int node) {
+  if (node < 0 || node >= TA_NUMA_MAX_NODES) return 0;
+  return A(g_seg->node[node]).load(std::memory_order_relaxed);
+}
+
+// For stats: sweeps first (rate limited), so the totals read after it are current
+extern "C" int __ta_shared_processes(void) {
+  if (!g_on.load(std::memory_order_relaxed)) return 0;
+  maybe_sweep();
+  int n = 0;
+  for (Slot& s : g_seg->slots) if (A(s.pid).load(std::memory_order_relaxed) > 0) ++n;
+  return n;
+}
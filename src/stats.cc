@@ -28,11 +28,13 @@ struct Counters {
   std::atomic<unsigned long long> mig_attempted{0};
   std::atomic<unsigned long long> mig_moved_pages{0};
   std::atomic<unsigned long long> mig_failed_pages{0};
+  std::atomic<unsigned long long> place_failures{0};   // mbind refused a tier policy
 
   // Backend & node topology
   std::string backend{"simulated"};
   int nodes_map[3]{0,0,0};
   int node_count{1};
+  std::vector<int> tier_nodes[3]{{0},{0},{0}};
 
   // Bytes per node (size set once via __ta_set_node_count)
   std::unique_ptr<std::atomic<unsigned long long>[]> node_bytes;
@@ -43,6 +45,16 @@ std::mutex g_cfg_mtx;
 
 } // namespace
 
+extern "C" const char* __ta_copy_kernel_name(void);
+extern "C" bool __ta_shared_enabled(void);
+extern "C" void __ta_shared_tier_add(int tier, long long delta);
+extern "C" void __ta_shared_node_add(int node, long long delta);
+extern "C" unsigned long long __ta_shared_tier_bytes(int tier);
+extern "C" unsigned long long __ta_shared_node_bytes(int node);
+extern "C" int __ta_shared_processes(void);
+extern "C" int __ta_pressure_json(char* buf, unsigned long long n);
+extern "C" unsigned long long ta_config_version(void);
+
 // --- Public P0 snapshot remains the same for backward compatibility ---
 extern "C" void ta_get_stats(ta_stats_snapshot_t* out) {
   if (!out) return;
@@ -69,8 +81,11 @@ extern "C" int ta_stats_json(char* buf, unsigned long long n) {
     btf[i]= s.bytes_total_freed[i].load(std::memory_order_relaxed);
     w[i]  = s.simulated_wait_ns[i].load(std::memory_order_relaxed);
     cv[i] = s.capacity_violations[i].load(std::memory_order_relaxed);
-    soft[i]= s.capacity_soft[i];
-    hard[i]= s.capacity_hard[i];
+  }
+  {
+    // Caps can be replaced at runtime (ta_set_caps)
+    std::scoped_lock lk(g_cfg_mtx);
+    for (int i=0;i<3;++i) { soft[i] = s.capacity_soft[i]; hard[i] = s.capacity_hard[i]; }
   }
   unsigned long long migA = s.mig_attempted.load(std::memory_order_relaxed);
   unsigned long long migM = s.mig_moved_pages.load(std::memory_order_relaxed);
@@ -90,8 +105,18 @@ extern "C" int ta_stats_json(char* buf, unsigned long long n) {
   arr3("capacity_soft", soft);
   arr3("capacity_hard", hard);
   arr3("capacity_violations", cv);
+  oss << "\"config_version\":" << ta_config_version() << ",";
   oss << "\"backend\":\"" << s.backend << "\",";
+  oss << "\"copy_kernel\":\"" << __ta_copy_kernel_name() << "\",";
   oss << "\"nodes\":[" << s.nodes_map[0] << "," << s.nodes_map[1] << "," << s.nodes_map[2] << "],";
+  oss << "\"tier_nodes\":[";
+  for (int t = 0; t < 3; t++) {
+    oss << "[";
+    for (size_t i = 0; i < s.tier_nodes[t].size(); i++)
+      oss << s.tier_nodes[t][i] << (i+1<s.tier_nodes[t].size() ? "," : "");
+    oss << "]" << (t<2 ? "," : "");
+  }
+  oss << "],";
   oss << "\"node_count\":" << s.node_count << ",";
   // bytes_per_node
   oss << "\"bytes_per_node\":[";
@@ -104,7 +129,21 @@ extern "C" int ta_stats_json(char* buf, unsigned long long n) {
   // migrations
   oss << "\"migrations\":{\"attempted\":" << migA
       << ",\"moved_pages\":" << migM
-      << ",\"failed_pages\":" << migF << "}";
+      << ",\"failed_pages\":" << migF << "},";
+  oss << "\"place_failures\":" << s.place_failures.load(std::memory_order_relaxed) << ",";
+  // host-wide totals across TA_SHARED processes
+  oss << "\"shared\":{\"enabled\":" << (__ta_shared_enabled() ? "true" : "false");
+  if (__ta_shared_enabled()) {
+    const int procs = __ta_shared_processes();
+    unsigned long long hb[3];
+    for (int i = 0; i < 3; ++i) hb[i] = __ta_shared_tier_bytes(i);
+    oss << ",\"processes\":" << procs
+        << ",\"host_bytes_current\":[ " << hb[0] << ", " << hb[1] << ", " << hb[2] << " ]";
+  }
+  oss << "},";
+  char pj[256];
+  __ta_pressure_json(pj, sizeof(pj));
+  oss << "\"pressure\":" << pj;
 
   std::string json = oss.str();
   if (!json.empty() && json.back()==',') json.back() = '}';
@@ -120,33 +159,62 @@ extern "C" int ta_stats_json(char* buf, unsigned long long n) {
 
 // --- Internal helpers used by allocator/policy/numa ---
 
-extern "C" void __ta_add_alloc(ta_tier_t t, unsigned long long sz, long wait_ns) {
+// Batch forms: `calls` allocations/frees totalling sz bytes, one update per counter
+extern "C" void __ta_add_alloc_n(ta_tier_t t, unsigned long long calls, unsigned long long sz, long wait_ns) {
   auto& s = S();
-  s.alloc_calls[(int)t]++;
+  s.alloc_calls[(int)t] += calls;
   s.bytes_current[(int)t] += sz;
   s.bytes_total_alloc[(int)t] += sz;
   if (wait_ns > 0) s.simulated_wait_ns[(int)t] += (unsigned long long)wait_ns;
+  __ta_shared_tier_add((int)t, (long long)sz);
 }
 
-extern "C" void __ta_add_free(ta_tier_t t, unsigned long long sz) {
+extern "C" void __ta_add_free_n(ta_tier_t t, unsigned long long calls, unsigned long long sz) {
   auto& s = S();
-  s.free_calls[(int)t]++;
+  s.free_calls[(int)t] += calls;
   s.bytes_current[(int)t] -= sz;
   s.bytes_total_freed[(int)t] += sz;
+  __ta_shared_tier_add((int)t, -(long long)sz);
 }
 
-// Per-tier current (used by policy to check caps)
-extern "C" unsigned long long __ta_bytes_current(int tier) {
+extern "C" void __ta_add_alloc(ta_tier_t t, unsigned long long sz, long wait_ns) {
+  __ta_add_alloc_n(t, 1, sz, wait_ns);
+}
+
+extern "C" void __ta_add_free(ta_tier_t t, unsigned long long sz) {
+  __ta_add_free_n(t, 1, sz);
+}
+
+// In-place re-tiering (ta_advise): residency moves, no alloc/free calls are counted
+extern "C" void __ta_move_tier(ta_tier_t from, ta_tier_t to, unsigned long long sz, long wait_ns) {
+  auto& s = S();
+  s.bytes_current[(int)from] -= sz;
+  s.bytes_current[(int)to] += sz;
+  if (wait_ns > 0) s.simulated_wait_ns[(int)to] += (unsigned long long)wait_ns;
+  __ta_shared_tier_add((int)from, -(long long)sz);
+  __ta_shared_tier_add((int)to, (long long)sz);
+}
+
+// This process's residency per tier
+extern "C" unsigned long long __ta_local_bytes_current(int tier) {
   return S().bytes_current[tier].load(std::memory_order_relaxed);
 }
 
+// Per-tier current (used by policy to check caps); host-wide under TA_SHARED
+extern "C" unsigned long long __ta_bytes_current(int tier) {
+  if (__ta_shared_enabled()) return __ta_shared_tier_bytes(tier);
+  return __ta_local_bytes_current(tier);
+}
+
 // Set capacity snapshots for stats (called from policy init)
 extern "C" void __ta_set_capacity_soft(const unsigned long long soft[3]) {
   auto& s = S();
+  std::scoped_lock lk(g_cfg_mtx);
   for (int i=0;i<3;i++) s.capacity_soft[i] = soft[i];
 }
 extern "C" void __ta_set_capacity_hard(const unsigned long long hard[3]) {
   auto& s = S();
+  std::scoped_lock lk(g_cfg_mtx);
   for (int i=0;i<3;i++) s.capacity_hard[i] = hard[i];
 }
 extern "C" void __ta_inc_capacity_violation(int tier) {
@@ -160,6 +228,10 @@ extern "C" void __ta_set_backend(const char* name) {
 extern "C" void __ta_set_node_mapping(int fast, int normal, int slow) {
   S().nodes_map[0] = fast; S().nodes_map[1] = normal; S().nodes_map[2] = slow;
 }
+extern "C" void __ta_set_tier_nodes(int tier, const int* nodes, int n) {
+  if (tier < 0 || tier > 2 || !nodes || n <= 0) return;
+  S().tier_nodes[tier].assign(nodes, nodes + n);
+}
 extern "C" void __ta_set_node_count(int count) {
   auto& s = S();
   s.node_count = std::max(1, count);
@@ -172,6 +244,7 @@ extern "C" void __ta_set_node_count(int count) {
 extern "C" void __ta_bytes_node_add(int node, long long delta) {
   auto& s = S();
   if (node < 0 || node >= s.node_count || !s.node_bytes) return;
+  __ta_shared_node_add(node, delta);
   if (delta >= 0) {
     s.node_bytes[node].fetch_add((unsigned long long)delta, std::memory_order_relaxed);
   } else {
@@ -184,6 +257,21 @@ extern "C" void __ta_bytes_node_add(int node, long long delta) {
   }
 }
 
+extern "C" unsigned long long __ta_local_node_bytes_current(int node) {
+  auto& s = S();
+  if (node < 0 || node >= s.node_count || !s.node_bytes) return 0;
+  return s.node_bytes[node].load(std::memory_order_relaxed);
+}
+
+extern "C" unsigned long long __ta_node_bytes_current(int node) {
+  if (__ta_shared_enabled()) return __ta_shared_node_bytes(node);
+  return __ta_local_node_bytes_current(node);
+}
+
+extern "C" void __ta_inc_place_failure(void) {
+  S().place_failures++;
+}
+
 // Migration counters
 extern "C" void __ta_add_migration(unsigned long long attempted, unsigned long long moved_pages, unsigned long long failed_pages) {
   auto& s = S();
@@ -42,6 +42,25 @@ extern "C" void ta_set_default_config(void) {
     init_bucket(TA_TIER_SLOW,    5.0 * 1024 * 1024 * 1024, 40'000);
 }
 
+// Retune one tier without dropping its current token balance; base_latency_ns < 0 keeps it
+extern "C" void __ta_throttle_set_tier(ta_tier_t tier, double bw_Bps, long base_latency_ns) {
+    auto& b = g_buckets[static_cast<size_t>(tier)];
+    std::scoped_lock lk(b.mtx);
+    if (bw_Bps > 0.0) {
+        b.rate_Bps = bw_Bps;
+        b.capacity_bytes = std::max(1.0, bw_Bps * 0.010);
+        b.tokens = std::min(b.tokens, b.capacity_bytes);
+    }
+    if (base_latency_ns >= 0) b.base_latency_ns = base_latency_ns;
+}
+
+extern "C" void __ta_throttle_get_tier(ta_tier_t tier, double* bw_Bps, long* base_latency_ns) {
+    auto& b = g_buckets[static_cast<size_t>(tier)];
+    std::scoped_lock lk(b.mtx);
+    if (bw_Bps) *bw_Bps = b.rate_Bps;
+    if (base_latency_ns) *base_latency_ns = b.base_latency_ns;
+}
+
 extern "C" long ta_charge_bytes(ta_tier_t tier, unsigned long long bytes, ta_charge_info_t* info) {
     auto& b = g_buckets[static_cast<size_t>(tier)];
     std::scoped_lock lk(b.mtx);
@@ -1,6 +1,10 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include "tieralloc.h"
 
 static void print_stats() { 
@@ -17,12 +21,61 @@ static void print_stats() {
     std::free(buf);
 }
 
+// Send one command line to a process serving TA_CTL_SOCKET and print the reply
+static int ctl(const char* path, int argc, char** argv) {
+    std::string cmd;
+    for (int i = 0; i < argc; ++i) {
+        if (i) cmd += ' ';
+        cmd += argv[i];
+    }
+    cmd.push_back('\n');
+
+    sockaddr_un addr{};
+    if (std::strlen(path) >= sizeof(addr.sun_path)) { std::fprintf(stderr, "ctl: socket path too long\n"); return 1; }
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::fprintf(stderr, "ctl: cannot connect to %s\n", path);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    if (write(fd, cmd.data(), cmd.size()) != (ssize_t)cmd.size()) { close(fd); return 1; }
+    shutdown(fd, SHUT_WR);
+
+    std::string reply;
+    char buf[4096];
+    ssize_t r;
+    while ((r = read(fd, buf, sizeof(buf))) > 0) reply.append(buf, (size_t)r);
+    close(fd);
+    fwrite(reply.data(), 1, reply.size(), stdout);
+    return reply.compare(0, 6, "error:") == 0 ? 1 : 0;
+}
+
 int main(int argc, char** argv) {
+    if (argc > 3 && std::strcmp(argv[1], "ctl")==0) {
+        return ctl(argv[2], argc - 3, argv + 3);
+    }
     ta_init_from_env();
     if (argc > 1 && std::strcmp(argv[1], "stats")==0) {
         print_stats();
         return 0;
     }
+    if (argc > 1 && std::strcmp(argv[1], "calibrate")==0) {
+        const char* path = (argc > 2) ? argv[2] : nullptr;
+        int rc = ta_calibrate(path);
+        if (rc == -3) {
+            std::fprintf(stderr, "calibrate: needs the numa backend (TA_USE_LIBNUMA=1 on a NUMA host)\n");
+            return 1;
+        }
+        if (rc != 0) {
+            std::fprintf(stderr, "calibrate: failed to measure or write %s\n", path ? path : "config");
+            return 1;
+        }
+        const char* shown = path ? path : std::getenv("TA_CONFIG");
+        std::printf("wrote %s\n", (shown && *shown) ? shown : "/etc/tieralloc.conf");
+        return 0;
+    }
     std::printf("%s\n", ta_hello());
     print_stats();
     return 0;